@@ -1,712 +1,6659 @@
 #include <GL/glut.h>
+#ifdef FREEGLUT
+#include <GL/freeglut_ext.h> // glutGetProcAddress
+#endif
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
 #include <vector>
 #include <string>
 #include <cstdio> 
-#include <algorithm> // Required for std::remove_if
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cassert>
 
-// Window dimensions
-const int WIDTH = 800;
-const int HEIGHT = 600;
+// SIMD instruction sets available to this build (Chosen at runtime from CPU features)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SD_SSE2 1
+#define SD_AVX2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SD_TARGET_AVX2
+#else
+#define SD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON)
+#define SD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Logical playfield in game units (Override with --playfield=WxH). Simulation, layout and
+// the projection all work in these units; the window only decides how many pixels they get.
+struct Playfield {
+    int width = 800;
+    int height = 600;
+} playfield;
 
 // Game states
 enum GameState { MENU, PLAYING, GAME_OVER };
-GameState gameState = MENU;
 
 // Player properties
 struct Player {
     float x, y;
+    float prevX, prevY; // Position at the start of the last tick (For render interpolation)
     float size;
     float speed;
     int lives;
     int score;
-} player;
+};
 
-// Bullet structure
-struct Bullet {
-    float x, y;
-    float speed;
-    bool active;
+// Structure-of-arrays storage for one kind of game object (Bullets, Enemies, Power-ups)
+// Live objects occupy indices [0, count). Removing one moves the last object
+// into its slot (swap-and-pop), so there is no active flag and no compaction.
+// Columns are allocated once with a fixed capacity (A pool): adding and removing
+// objects never touches the heap, and a full pool drops the new object.
+struct EntityStore {
+    std::vector<float> x, y;
+    std::vector<float> prevY;         // y at the start of the last tick (Objects only move vertically)
+    std::vector<float> speed;
+    std::vector<int> type;            // Enemies only: row of enemyArchetypes
+    std::vector<unsigned char> killed; // Hit this tick, removed by entityRemoveKilled()
+    int count = 0;
+    int capacity = 0;
+    long long exhausted = 0;          // Objects dropped because the pool was full
 };
 
-// Enemy structure
-struct Enemy {
-    float x, y;
-    float speed;
-    bool active;
-    int type; // 0: circle, 1: triangle, 2: square
+// Pool capacities (Override with --pool-bullets=N, --pool-enemies=N, --pool-powerups=N)
+struct PoolConfig {
+    int bullets = 512;
+    int enemies = 2048;
+    int powerUps = 64;
+} poolConfig;
+
+// === GAME LEVEL & DIFFICULTY VARIABLES ===
+// Rules shared by every World (Read-only while worlds are stepping, see WORLD)
+
+// Controls (Input itself reaches update() as one TickCommand per tick, see INPUT)
+int fireCooldownTicks = 6; // --fire-cooldown=N: game ticks between shots (0 = no limit, stored in replays)
+bool legacyFire = false;   // Version 1-2 replays: every press fires at once, holding does not
+bool sweptContacts = true; // Contact tests along each step's motion (Version 1-4 replays: endpoints only)
+
+// Benchmark overrides (Set from the command line in headless mode, 0 = normal game rules)
+int forcedSpawnRate = 0; // Ticks between enemy spawns
+int spawnBurst = 1;      // Enemies per spawn
+// Perf suite stress rules (Not stored in replays, so the suite never records)
+int startLevel = 1;      // Level every game starts at
+int powerUpPeriod = 0;   // Game ticks between power-ups (0 = POWER_UP_PERIOD)
+
+// === RANDOM NUMBERS ===
+// Explicitly seeded PCG32 generator, so a seed always reproduces the same game.
+struct Random {
+    uint64_t state;
+    uint64_t increment;
 };
 
-// Power-up structure
-struct PowerUp {
-    float x, y;
-    float speed;
-    bool active;
+uint32_t randomNext(Random& rng) {
+    uint64_t old = rng.state;
+    rng.state = old * 6364136223846793005ULL + rng.increment;
+    uint32_t shifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rotation = (uint32_t)(old >> 59);
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+}
+
+void seedRandom(Random& rng, uint64_t seed) {
+    rng.state = 0;
+    rng.increment = (seed << 1) | 1;
+    randomNext(rng);
+    rng.state += seed;
+    randomNext(rng);
+}
+
+// Random integer in [0, n) (Drop-in for rand() % n)
+int randomInt(Random& rng, int n) {
+    return (int)(randomNext(rng) % (uint32_t)n);
+}
+
+// === ALLOCATION COUNTER ===
+// Every global operator new is counted so the benchmark can report heap traffic.
+// Kept out of line, otherwise GCC sees malloc/free pairs through std::allocator and warns.
+// Each block also carries a small header with its size and the memory tag of the code
+// that allocated it (A MemoryTagScope further up the call stack, "other" without one), so
+// live bytes, peak bytes and allocation counts are kept per subsystem. The arenas report
+// their malloc blocks under their own tag. Shown in the F3 overlay and by --memory-stats.
+#ifdef _MSC_VER
+#define SD_NOINLINE __declspec(noinline)
+#else
+#define SD_NOINLINE __attribute__((noinline))
+#endif
+
+std::atomic<long long> allocationCount(0);
+thread_local long long threadAllocationCount = 0; // Same count, per thread (NoAllocationScope)
+
+enum MemoryTag {
+    MEMORY_OTHER,     // Untagged: startup, threads, the C++ runtime
+    MEMORY_ENTITIES,  // Object pools, spatial grid, scheduler, tick arenas
+    MEMORY_RENDER,    // Frame arena, snapshots, GPU staging, particles
+    MEMORY_TEXT,      // Font atlas and text drawing
+    MEMORY_REPLAY,    // Replay recording and playback, save states
+    MEMORY_TAG_COUNT
 };
 
-// Vector dynamic data type (Containers for game objects)
-std::vector<Bullet> bullets;
-std::vector<Enemy> enemies;
-std::vector<PowerUp> powerUps;
+const char* memoryTagNames[MEMORY_TAG_COUNT] = { "other", "entities", "render", "text", "replay" };
 
-// Animation variables
-float starOffset = 0;
-float enemySpawnTimer = 0;
-float powerUpTimer = 0;
+struct MemoryCounters {
+    std::atomic<long long> live{ 0 };        // Bytes allocated and not yet freed
+    std::atomic<long long> peak{ 0 };        // Highest live so far
+    std::atomic<long long> allocations{ 0 }; // Blocks allocated so far
+};
 
-// === GAME LEVEL & DIFFICULTY VARIABLES ===
-float gameLevelTimer = 0;
-int currentLevel = 1;
-int enemySpawnRate = 60; // Initial rate: 60 frames = 1 enemy/second
-float lastHitTimer = 0;  // Timer for no-hit penalty
-int playerShape = 0;     // Locked to Triangle (0)
+MemoryCounters memoryCounters[MEMORY_TAG_COUNT];
+MemoryCounters memoryProcess; // Every tag together (Its peak is a real process-wide peak)
+thread_local int memoryTag = MEMORY_OTHER;
+
+// Attribute this thread's allocations to tag until the scope ends (Scopes nest)
+struct MemoryTagScope {
+    int saved;
+    explicit MemoryTagScope(MemoryTag tag) : saved(memoryTag) { memoryTag = tag; }
+    ~MemoryTagScope() { memoryTag = saved; }
+};
+
+void memoryCount(MemoryCounters& counters, size_t bytes) {
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    long long live = counters.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    long long peak = counters.peak.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+void memoryAcquire(int tag, size_t bytes) {
+    memoryCount(memoryCounters[tag], bytes);
+    memoryCount(memoryProcess, bytes);
+}
+
+void memoryRelease(int tag, size_t bytes) {
+    memoryCounters[tag].live.fetch_sub(bytes, std::memory_order_relaxed);
+    memoryProcess.live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+// Restart every peak from its current live bytes (Peaks of one benchmark phase)
+void memoryResetPeaks() {
+    for (MemoryCounters& counters : memoryCounters) {
+        counters.peak.store(counters.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    memoryProcess.peak.store(memoryProcess.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Allocations per displayed frame and tag, on every thread (Sampled at the top of display())
+struct MemoryFrameStats {
+    long long seen[MEMORY_TAG_COUNT] = {};
+    long long last[MEMORY_TAG_COUNT] = {}; // During the last frame
+    long long most[MEMORY_TAG_COUNT] = {}; // Worst frame so far
+    long long frames = 0;
+} memoryFrames;
+
+void memorySampleFrame() {
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        long long allocations = memoryCounters[tag].allocations.load(std::memory_order_relaxed);
+        memoryFrames.last[tag] = allocations - memoryFrames.seen[tag];
+        memoryFrames.seen[tag] = allocations;
+        // The first sample holds all of startup
+        if (memoryFrames.frames > 0) memoryFrames.most[tag] = std::max(memoryFrames.most[tag], memoryFrames.last[tag]);
+    }
+    memoryFrames.frames++;
+}
+
+// In front of every operator new block; 16 bytes keep malloc's alignment
+struct alignas(16) MemoryHeader {
+    size_t size;
+    int tag;
+};
+
+SD_NOINLINE void* operator new(size_t size) {
+    allocationCount++;
+    threadAllocationCount++;
+    MemoryHeader* header = (MemoryHeader*)malloc(sizeof(MemoryHeader) + size);
+    if (!header) throw std::bad_alloc();
+    header->size = size;
+    header->tag = memoryTag;
+    memoryAcquire(header->tag, size);
+    return header + 1;
+}
+
+SD_NOINLINE void operator delete(void* p) noexcept {
+    if (!p) return;
+    MemoryHeader* header = (MemoryHeader*)p - 1;
+    memoryRelease(header->tag, header->size);
+    free(header);
+}
+
+SD_NOINLINE void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+// === FRAME ARENAS ===
+// Transient data of one tick or one frame (Hit lists, vertex arrays, draw orders) is
+// bump-allocated from a linear arena that is reset at the top of update()/display().
+// Allocating is one atomic add, so job chunks can share the tick arena. A request past
+// the end gets a spill block from malloc, and at the next reset the arena is enlarged
+// to the peak it saw, so a steady-state frame never reaches the heap.
+const size_t ARENA_ALIGNMENT = 16;
+const int MAX_ARENA_SPILLS = 32;
+
+struct FrameArena {
+    unsigned char* memory = NULL;
+    size_t capacity = 0;
+    std::atomic<size_t> used{ 0 };  // Bytes handed out since the reset (Spills included)
+    size_t peak = 0;                // Largest frame so far
+    uint32_t epoch = 0;             // Incremented by every reset
+    void* spills[MAX_ARENA_SPILLS];
+    int spillCount = 0;
+    size_t spillBytes = 0;
+    long long grows = 0;            // Resets that had to enlarge the arena
+    int tag = MEMORY_OTHER;         // Memory tag of its blocks (Set before the first reserve)
+    std::mutex spillLock;
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // The block and any spills go back to malloc and leave the tag's counters
+    ~FrameArena() {
+        for (int i = 0; i < spillCount; i++) free(spills[i]);
+        memoryRelease(tag, capacity + spillBytes);
+        free(memory);
+    }
+};
+
+FrameArena frameArena; // display(): GLUT thread (Each World has its own tick arena)
+
+// Startup, and resets after a spill (Not through operator new, see NoAllocationScope)
+void arenaReserve(FrameArena& arena, size_t bytes) {
+    if (arena.memory) memoryRelease(arena.tag, arena.capacity);
+    free(arena.memory);
+    arena.memory = (unsigned char*)malloc(bytes);
+    if (!arena.memory) throw std::bad_alloc();
+    arena.capacity = bytes;
+    memoryAcquire(arena.tag, bytes);
+}
+
+void* arenaAllocate(FrameArena& arena, size_t bytes) {
+    bytes = (bytes + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    size_t offset = arena.used.fetch_add(bytes, std::memory_order_relaxed);
+    if (offset + bytes <= arena.capacity) return arena.memory + offset;
+
+    std::lock_guard<std::mutex> lock(arena.spillLock);
+    void* block = arena.spillCount < MAX_ARENA_SPILLS ? malloc(bytes) : NULL;
+    if (!block) throw std::bad_alloc();
+    arena.spills[arena.spillCount++] = block;
+    arena.spillBytes += bytes;
+    memoryAcquire(arena.tag, bytes);
+    return block;
+}
+
+// Everything allocated from the arena before this call is gone
+void arenaReset(FrameArena& arena) {
+    size_t used = arena.used.load(std::memory_order_relaxed);
+    arena.peak = std::max(arena.peak, used);
+    if (arena.spillCount > 0) {
+        for (int i = 0; i < arena.spillCount; i++) free(arena.spills[i]);
+        memoryRelease(arena.tag, arena.spillBytes);
+        arena.spillCount = 0;
+        arena.spillBytes = 0;
+        arenaReserve(arena, arena.peak + arena.peak / 2);
+        arena.grows++;
+    }
+    arena.used.store(0, std::memory_order_relaxed);
+    arena.epoch++;
+}
 
-// Controls
-bool keys[256] = { false };
+// Growable array of trivially copyable items in an arena. Growing copies into a bigger
+// block (The old one is abandoned until the reset). Contents do not survive a reset: the
+// first use after one starts empty, with last frame's capacity.
+template <typename T>
+struct ArenaArray {
+    FrameArena* arena = NULL; // Set once, before the first push_back
+    T* items = NULL;
+    int count = 0;
+    int capacity = 0;
+    uint32_t epoch = 0;
+    int reserved = 16; // Capacity to start the next frame with
+
+    bool current() const { return items && epoch == arena->epoch; }
+
+    void grow() {
+        int keep = current() ? count : 0;
+        int size = std::max(reserved, current() ? capacity * 2 : 0);
+        T* grown = (T*)arenaAllocate(*arena, size * sizeof(T));
+        if (keep) memcpy(grown, items, keep * sizeof(T));
+        items = grown;
+        count = keep;
+        capacity = reserved = size;
+        epoch = arena->epoch;
+    }
+
+    void push_back(const T& item) {
+        if (!current() || count == capacity) grow();
+        items[count++] = item;
+    }
+
+    void clear() { count = 0; }
+    size_t size() const { return current() ? count : 0; }
+    bool empty() const { return size() == 0; }
+    T* data() { return items; }
+    const T* data() const { return items; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + size(); }
+};
+
+// Debug builds: assert that no operator new runs on this thread while the scope is alive
+// (Steady-state PLAYING ticks and frames). Arena spills use malloc and are not counted;
+// they show up as arena grows in the F3 overlay and the headless report instead.
+struct NoAllocationScope {
+#ifndef NDEBUG
+    bool active;
+    long long before;
+    explicit NoAllocationScope(bool active) : active(active), before(threadAllocationCount) {}
+    ~NoAllocationScope() {
+        assert(!active || threadAllocationCount == before);
+    }
+#else
+    explicit NoAllocationScope(bool) {}
+#endif
+};
 
 // --- Function Prototypes ---
 void drawCircleMidpoint(float cx, float cy, float r);
 void drawFilledCircle(float cx, float cy, float r);
 void drawLineBresenham(int x1, int y1, int x2, int y2);
 void drawText(float x, float y, const char* text);
-void drawStars();
-void update(int value);
+void drawStars(float offset);
+void buildStarfield();
+void buildRasterShaders();
+void buildInstancedRenderer();
+void buildParticleRenderer();
 
 
-// Initialize game
-void init() {
-    glClearColor(0.0, 0.0, 0.1, 1.0);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    // Set 2D coordinates: (0, 0) is bottom-left
-    gluOrtho2D(0, WIDTH, 0, HEIGHT);
-    glMatrixMode(GL_MODELVIEW);
+// Allocate the columns of a pool (Startup only)
+void entityReserve(EntityStore& store, int capacity) {
+    store.capacity = capacity;
+    store.x.assign(capacity, 0);
+    store.y.assign(capacity, 0);
+    store.prevY.assign(capacity, 0);
+    store.speed.assign(capacity, 0);
+    store.type.assign(capacity, 0);
+    store.killed.assign(capacity, 0);
+    store.count = 0;
+}
 
-    // Initialize player
-    player.x = WIDTH / 2;
-    player.y = 50;
-    player.size = 20;
-    player.speed = 5.0f;
-    player.lives = 3;
-    player.score = 0;
+// Acquire a slot and fill it in (O(1), returns -1 and counts the miss when the pool is full)
+int entityAdd(EntityStore& store, float x, float y, float speed, int type) {
+    if (store.count == store.capacity) {
+        store.exhausted++;
+        return -1;
+    }
+    int i = store.count++;
+    store.x[i] = x;
+    store.y[i] = y;
+    store.prevY[i] = y;
+    store.speed[i] = speed;
+    store.type[i] = type;
+    store.killed[i] = 0;
+    return i;
+}
 
-    srand(time(NULL));
+// Release a slot with swap-and-pop (O(1), order of the remaining objects is not preserved)
+void entityRemove(EntityStore& store, int i) {
+    int last = --store.count;
+    store.x[i] = store.x[last];
+    store.y[i] = store.y[last];
+    store.prevY[i] = store.prevY[last];
+    store.speed[i] = store.speed[last];
+    store.type[i] = store.type[last];
+    store.killed[i] = store.killed[last];
 }
 
-// DDA Line Algorithm (Not used for primary drawing, but kept for completeness)
-void drawLineDDA(float x1, float y1, float x2, float y2) {
-    float dx = x2 - x1;
-    float dy = y2 - y1;
-    float steps = fabs(dx) > fabs(dy) ? fabs(dx) : fabs(dy);
+// Remove every object marked as killed (Walks backwards so swapped-in objects are already checked)
+void entityRemoveKilled(EntityStore& store) {
+    for (int i = store.count - 1; i >= 0; i--) {
+        if (store.killed[i]) entityRemove(store, i);
+    }
+}
 
-    float xInc = dx / steps;
-    float yInc = dy / steps;
+void entityClear(EntityStore& store) {
+    store.count = 0;
+}
 
-    float x = x1, y = y1;
+// === ENEMY ARCHETYPES ===
+// Every enemy kind is one row of enemyArchetypes; an enemy's type is its row index.
+// The simulation reads radii, score and speed from the row and the renderer draws
+// each archetype with the emitter of its shape, so a new enemy kind only needs a row.
+enum EnemyShape {
+    SHAPE_DISC,    // Filled circle of radius size with a midpoint outline
+    SHAPE_POLYGON, // Filled convex polygon (Fan over points)
+    SHAPE_OUTLINE, // Closed DDA line loop through points
+    SHAPE_COUNT
+};
 
-    glBegin(GL_POINTS);
-    for (int i = 0; i <= steps; i++) {
-        glVertex2f(round(x), round(y));
-        x += xInc;
-        y += yInc;
+struct EnemyArchetype {
+    const char* name;
+    EnemyShape shape;
+    float size;           // SHAPE_DISC radius
+    int pointCount;       // SHAPE_POLYGON / SHAPE_OUTLINE corners (At most 8)
+    float points[8][2];
+    float color[3];
+    float outline[3];     // SHAPE_DISC outline colour
+    float crashRadius;    // Added to player.size for enemy-player contact
+    float hitRadius;      // Bullet-enemy contact
+    int score;            // Awarded for shooting it
+    float speedMin;       // Speed = speedMin..speedMax (3 steps) + speedPerLevel * level
+    float speedMax;
+    float speedPerLevel;
+    int spawnWeight;      // Relative spawn chance
+};
+
+const EnemyArchetype enemyArchetypes[] = {
+    { "circle", SHAPE_DISC, 15, 0, {}, { 1.0f, 0.0f, 0.0f }, { 0.5f, 0.0f, 0.0f },
+        15, 20, 10, 2, 4, 0.5f, 1 },
+    { "triangle", SHAPE_POLYGON, 0, 3, { { 0, -20 }, { -15, 15 }, { 15, 15 } }, { 1.0f, 0.3f, 0.0f }, {},
+        15, 20, 10, 2, 4, 0.5f, 1 },
+    { "square", SHAPE_POLYGON, 0, 4, { { -15, -15 }, { 15, -15 }, { 15, 15 }, { -15, 15 } }, { 0.8f, 0.0f, 0.8f }, {},
+        15, 20, 10, 2, 4, 0.5f, 1 },
+    { "diamond", SHAPE_OUTLINE, 0, 4, { { 0, 20 }, { 20, 0 }, { 0, -20 }, { -20, 0 } }, { 0.0f, 1.0f, 1.0f }, {},
+        15, 20, 10, 2, 4, 0.5f, 1 },
+};
+const int ENEMY_ARCHETYPES = sizeof(enemyArchetypes) / sizeof(enemyArchetypes[0]);
+const int SPEED_STEPS = 3;
+
+// Largest radii over all archetypes (Broad-phase bounds, refined per archetype)
+float maxCrashRadius() {
+    float r = 0;
+    for (const EnemyArchetype& kind : enemyArchetypes) r = std::max(r, kind.crashRadius);
+    return r;
+}
+
+float maxHitRadius() {
+    float r = 0;
+    for (const EnemyArchetype& kind : enemyArchetypes) r = std::max(r, kind.hitRadius);
+    return r;
+}
+
+// === JOB SYSTEM ===
+// Small work-stealing pool for the per-tick sweeps. A submit splits a range into
+// chunks and deals them round-robin onto one queue per thread; each thread takes
+// from the back of its own queue and steals from the front of the others. The
+// submitting thread (Simulation or headless main) works too while it waits.
+// Jobs are plain function pointers into fixed rings, so a tick allocates nothing.
+const int MAX_JOB_THREADS = 16;
+const int JOB_QUEUE_SIZE = 256;
+const int MAX_JOB_CHUNKS = 64; // Chunks per submit (Per-chunk outputs are sized by this)
+
+struct JobGroup {
+    std::atomic<int> pending{ 0 };
+};
+
+struct Job {
+    void (*run)(void* context, int chunk, int begin, int end);
+    void* context;
+    int chunk, begin, end;
+    JobGroup* group;
+};
+
+struct JobQueue {
+    std::mutex lock;
+    Job jobs[JOB_QUEUE_SIZE];
+    int head = 0; // Thieves take from here
+    int tail = 0; // Owner pushes and pops here
+};
+
+struct JobSystem {
+    int threads = 1; // Including the submitting thread (Set with --jobs=N)
+    std::vector<std::thread> workers;
+    JobQueue queues[MAX_JOB_THREADS];
+    std::atomic<int> queued{ 0 };
+    std::atomic<bool> running{ false };
+    std::mutex sleepLock;
+    std::condition_variable wake;
+} jobs;
+
+thread_local int jobThreadIndex = 0; // 0 = submitting thread, 1.. = workers
+
+bool jobPush(int queue, const Job& job) {
+    JobQueue& q = jobs.queues[queue];
+    std::lock_guard<std::mutex> lock(q.lock);
+    if (q.tail - q.head == JOB_QUEUE_SIZE) return false;
+    q.jobs[q.tail++ % JOB_QUEUE_SIZE] = job;
+    return true;
+}
+
+bool jobPop(int queue, bool steal, Job& job) {
+    JobQueue& q = jobs.queues[queue];
+    std::lock_guard<std::mutex> lock(q.lock);
+    if (q.head == q.tail) return false;
+    job = steal ? q.jobs[q.head++ % JOB_QUEUE_SIZE] : q.jobs[--q.tail % JOB_QUEUE_SIZE];
+    return true;
+}
+
+void jobExecute(const Job& job) {
+    job.run(job.context, job.chunk, job.begin, job.end);
+    job.group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+// Run one queued job: own queue first, then steal (Returns false when everything is empty)
+bool jobRunOne(int self) {
+    Job job;
+    bool found = jobPop(self, false, job);
+    for (int k = 1; !found && k < jobs.threads; k++) {
+        found = jobPop((self + k) % jobs.threads, true, job);
     }
-    glEnd();
+    if (!found) return false;
+    jobs.queued.fetch_sub(1);
+    jobExecute(job);
+    return true;
 }
 
-// Bresenham's Line Algorithm (Used for Ship Wings)
-void drawLineBresenham(int x1, int y1, int x2, int y2) {
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-    int sx = (x1 < x2) ? 1 : -1;
-    int sy = (y1 < y2) ? 1 : -1;
-    int err = dx - dy;
+void jobWorker(int self) {
+    jobThreadIndex = self;
+    while (jobs.running.load()) {
+        if (jobRunOne(self)) continue;
 
-    glBegin(GL_POINTS);
-    while (true) {
-        glVertex2i(x1, y1);
+        // Spin briefly (Ticks arrive back to back in headless runs), then sleep until a submit
+        bool found = false;
+        for (int spin = 0; spin < 200 && !found; spin++) {
+            std::this_thread::yield();
+            found = jobs.queued.load() > 0;
+        }
+        if (found) continue;
+        std::unique_lock<std::mutex> lock(jobs.sleepLock);
+        jobs.wake.wait(lock, [] { return jobs.queued.load() > 0 || !jobs.running.load(); });
+    }
+}
 
-        if (x1 == x2 && y1 == y2) break;
+// Split [0, count) into chunks of at least grain items and queue them on the group.
+// fn(chunk, begin, end) must stay alive until jobWait(group). Chunk numbering only
+// depends on count and grain, so per-chunk outputs merge in a fixed order.
+template <typename Fn>
+int jobSubmit(JobGroup& group, int count, int grain, Fn& fn) {
+    if (count <= 0) return 0;
+    if (jobs.threads <= 1 || count <= grain) {
+        fn(0, 0, count);
+        return 1;
+    }
+    int chunkSize = std::max(grain, (count + MAX_JOB_CHUNKS - 1) / MAX_JOB_CHUNKS);
+    int chunks = (count + chunkSize - 1) / chunkSize;
 
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x1 += sx;
+    Job job;
+    job.run = [](void* context, int chunk, int begin, int end) { (*(Fn*)context)(chunk, begin, end); };
+    job.context = &fn;
+    job.group = &group;
+    for (int c = 0; c < chunks; c++) {
+        job.chunk = c;
+        job.begin = c * chunkSize;
+        job.end = std::min(count, job.begin + chunkSize);
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        if (jobPush((jobThreadIndex + c) % jobs.threads, job)) {
+            jobs.queued.fetch_add(1);
         }
-        if (e2 < dx) {
-            err += dx;
-            y1 += sy;
+        else {
+            jobExecute(job); // Queue full, run it here
         }
     }
-    glEnd();
+    {
+        std::lock_guard<std::mutex> lock(jobs.sleepLock);
+    }
+    jobs.wake.notify_all();
+    return chunks;
+}
+
+// Help with queued jobs until every job of the group has finished
+void jobWait(JobGroup& group) {
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        if (!jobRunOne(jobThreadIndex)) std::this_thread::yield();
+    }
+}
+
+template <typename Fn>
+int parallelFor(int count, int grain, Fn&& fn) {
+    JobGroup group;
+    int chunks = jobSubmit(group, count, grain, fn);
+    jobWait(group);
+    return chunks;
+}
+
+void stopJobs() {
+    {
+        std::lock_guard<std::mutex> lock(jobs.sleepLock);
+        jobs.running = false;
+    }
+    jobs.wake.notify_all();
+    for (std::thread& worker : jobs.workers) {
+        worker.join();
+    }
+    jobs.workers.clear();
+}
+
+// Start threads - 1 workers (1 = everything runs on the submitting thread)
+void startJobs(int threads) {
+    jobs.threads = std::max(1, std::min(threads, MAX_JOB_THREADS));
+    if (jobs.threads == 1) return;
+    jobs.running = true;
+    for (int i = 1; i < jobs.threads; i++) {
+        jobs.workers.emplace_back(jobWorker, i);
+    }
+    atexit(stopJobs);
+}
+
+// === SPATIAL GRID (Collision broad-phase) ===
+// Uniform grid over the playfield, rebuilt every tick with a counting sort.
+// Each cell lists the indices of the objects whose centre lies inside it, so a
+// collision query only visits the cells overlapped by its search radius.
+const int GRID_CELL_SIZE = 40;
+const float GRID_MIN_Y = -2 * GRID_CELL_SIZE; // Objects are culled below y = -30
+
+struct SpatialGrid {
+    int cols = 0, rows = 0;     // Cover the playfield (Set by gridReserve)
+    std::vector<int> cellStart; // First entry of each cell in cellItems (+1 sentinel)
+    std::vector<int> cellItems; // Object indices sorted by cell
+    std::vector<int> itemCell;  // Cell of each object (Scratch for the sort)
+};
+
+
+// Size the grid for up to capacity objects (Startup only, builds never allocate)
+void gridReserve(SpatialGrid& grid, int capacity) {
+    grid.cols = playfield.width / GRID_CELL_SIZE + 1;
+    grid.rows = (playfield.height - (int)GRID_MIN_Y) / GRID_CELL_SIZE + 2;
+    grid.cellStart.assign(grid.cols * grid.rows + 1, 0);
+    grid.cellItems.assign(capacity, 0);
+    grid.itemCell.assign(capacity, 0);
+}
+
+int gridColumn(const SpatialGrid& grid, float x) {
+    return std::max(0, std::min(grid.cols - 1, (int)floor(x / GRID_CELL_SIZE)));
+}
+
+int gridRow(const SpatialGrid& grid, float y) {
+    return std::max(0, std::min(grid.rows - 1, (int)floor((y - GRID_MIN_Y) / GRID_CELL_SIZE)));
+}
+
+// Rebuild the grid from count objects (position(i, x, y) reports object i)
+template <typename Position>
+void gridBuild(SpatialGrid& grid, int count, Position position) {
+    std::fill(grid.cellStart.begin(), grid.cellStart.end(), 0);
+
+    // Count objects per cell
+    for (int i = 0; i < count; i++) {
+        float x, y;
+        position(i, x, y);
+        int cell = gridRow(grid, y) * grid.cols + gridColumn(grid, x);
+        grid.itemCell[i] = cell;
+        grid.cellStart[cell + 1]++;
+    }
+
+    // Prefix sum gives the first slot of every cell
+    for (int c = 0; c < grid.cols * grid.rows; c++) {
+        grid.cellStart[c + 1] += grid.cellStart[c];
+    }
+
+    // Scatter indices into their cells (cellStart is shifted back afterwards)
+    for (int i = 0; i < count; i++) {
+        grid.cellItems[grid.cellStart[grid.itemCell[i]]++] = i;
+    }
+    for (int c = grid.cols * grid.rows; c > 0; c--) {
+        grid.cellStart[c] = grid.cellStart[c - 1];
+    }
+    grid.cellStart[0] = 0;
+}
+
+// Call visit(i) for every object in the cells overlapped by the circle (x, y, r)
+template <typename Visit>
+void gridQuery(const SpatialGrid& grid, float x, float y, float r, Visit visit) {
+    int col0 = gridColumn(grid, x - r), col1 = gridColumn(grid, x + r);
+    int row0 = gridRow(grid, y - r), row1 = gridRow(grid, y + r);
+
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            int cell = row * grid.cols + col;
+            for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                visit(grid.cellItems[k]);
+            }
+        }
+    }
+}
+
+// Narrow-phase test (Squared distances, no sqrt)
+bool withinRadius(float ax, float ay, float bx, float by, float r) {
+    float dx = ax - bx;
+    float dy = ay - by;
+    return dx * dx + dy * dy < r * r;
+}
+
+// Swept narrow-phase: a moves (ax0, ay0) -> (ax1, ay1) and b moves (bx0, by0) -> (bx1, by1)
+// during the step. Seen from b, a moves along one segment, so the two come within r
+// exactly when the point of that segment closest to b does (Segment vs circle). A fast
+// object cannot step over a target this way, whatever the speed or tick rate.
+bool sweptWithinRadius(float ax0, float ay0, float ax1, float ay1,
+    float bx0, float by0, float bx1, float by1, float r) {
+    float px = ax0 - bx0, py = ay0 - by0;                // Start, relative to b
+    float dx = (ax1 - bx1) - px, dy = (ay1 - by1) - py;  // Relative motion
+    float length = dx * dx + dy * dy;
+    float t = length > 0 ? -(px * dx + py * dy) / length : 0;
+    t = std::max(0.0f, std::min(1.0f, t));
+    float cx = px + dx * t;
+    float cy = py + dy * t;
+    return cx * cx + cy * cy < r * r;
+}
+
+// Largest distance an object of the store moved this step (Objects only move vertically)
+float maxStep(const EntityStore& store) {
+    float step = 0;
+    for (int i = 0; i < store.count; i++) {
+        step = std::max(step, fabsf(store.y[i] - store.prevY[i]));
+    }
+    return step;
+}
+
+// === EVENT SCHEDULER ===
+// Spawns, level-ups and the no-hit penalty are timed events on a timing wheel instead
+// of counters polled every tick. An event due within WHEEL_SLOTS ticks sits in the
+// list of its slot; later ones wait in a min-heap and move into the wheel once they are
+// in range. Each tick only visits the current slot and the top of the heap, so the
+// cost per tick does not depend on how many events are pending.
+enum EventKind {
+    // Events due on the same tick run in this order
+    EVENT_LEVEL_UP,
+    EVENT_NO_HIT_PENALTY,
+    EVENT_ENEMY_SPAWN,
+    EVENT_POWER_UP_SPAWN,
+    EVENT_WAVE,
+    EVENT_KINDS
+};
+
+const int WHEEL_SLOTS = 1024; // Power of two
+const int MAX_EVENTS = 4096;
+
+struct TimedEvent {
+    long long due;
+    EventKind kind;
+    int next;           // Next event in the same slot list (-1 = last)
+    bool cancelled;
+    int count;          // EVENT_WAVE: enemies still to spawn
+    int archetype;      // EVENT_WAVE: row of enemyArchetypes, -1 = random
+    int interval;       // EVENT_WAVE: ticks between spawns (0 = all at once)
+};
+
+struct EventScheduler {
+    TimedEvent events[MAX_EVENTS];
+    int freeList = -1;
+    int head[WHEEL_SLOTS][EVENT_KINDS];
+    int tail[WHEEL_SLOTS][EVENT_KINDS];
+    uint64_t occupied[WHEEL_SLOTS / 64]; // Slots with an event in them (For save states)
+    std::vector<int> later;       // Min-heap (On due) of events beyond the wheel
+    long long now = 0;            // Game ticks since resetGame()
+    int running = EVENT_KINDS;    // Kind being run this tick (EVENT_KINDS = none)
+    long long dropped = 0;        // Events lost because the pool was full
+};
+
+// Heap order of EventScheduler::later (Earliest due on top)
+struct LaterFirst {
+    const EventScheduler& scheduler;
+    bool operator()(int a, int b) const { return scheduler.events[a].due > scheduler.events[b].due; }
+};
+
+// Difficulty per level: ticks between regular spawns and enemies per spawn.
+// A level can spawn several enemies at once, so the rate is not limited to one per tick.
+struct DifficultyLevel {
+    int spawnPeriod;
+    int spawnCount;
+};
+const DifficultyLevel difficultyLevels[] = { { 61, 1 }, { 36, 1 }, { 11, 1 } };
+const int MAX_LEVEL = sizeof(difficultyLevels) / sizeof(difficultyLevels[0]);
+const int LEVEL_TICKS = 900;      // Every 15 seconds
+const int NO_HIT_TICKS = 300;     // Penalty after 5 seconds without a hit
+const int POWER_UP_PERIOD = 301;  // Every 5 seconds
+
+// Scripted enemy waves (Loaded with --waves=FILE, scheduled again by every resetGame)
+struct WaveScript {
+    long long tick;     // Game tick of the first spawn
+    int count;
+    int archetype;      // -1 = random
+    int interval;
+};
+std::vector<WaveScript> waveScripts;
+
+// === WORLD ===
+// Everything one game changes while it runs, with the functions that change it. Worlds
+// share nothing but the read-only rules above (Playfield, pool sizes, tick rate, spawn
+// overrides, waves), so independent worlds can step concurrently, one per thread.
+// The window game plays the global world; --worlds=N benchmarks many side by side.
+//   reset(seed) starts over in MENU, step(intent) runs one tick of input and
+//   observe(snapshot) copies the visible state out (Into pre-sized views, no allocation).
+struct GameSnapshot;
+struct SaveState;
+struct InputIntent;
+struct TickCommand;
+
+// Bullet-enemy contacts gathered by one chunk of bullets (Applied in order afterwards)
+struct HitPair {
+    int bullet;
+    int enemy;
+};
+
+// Something the renderer may want to show (Particles), reported by the tick it happened in.
+// Effects are output only: nothing in the game reads them back.
+enum EffectKind { EFFECT_SPARK, EFFECT_EXPLOSION, EFFECT_PLAYER_HIT, EFFECT_PICKUP };
+
+struct Effect {
+    unsigned char kind;
+    unsigned char archetype; // EFFECT_EXPLOSION: row of enemyArchetypes
+    float x, y;
+};
+
+struct World {
+    GameState gameState = MENU;
+    Player player = Player();
+    EntityStore bullets;
+    EntityStore enemies;
+    EntityStore powerUps;
+
+    // Animation variables
+    float starOffset = 0;
+    float prevStarOffset = 0;
+
+    int currentLevel = 1;
+    int playerShape = 0;       // Locked to Triangle (0)
+    int fireCooldown = 0;      // Game ticks until the next shot is allowed
+    bool fireQueued = false;   // A press waiting for the cooldown
+
+    Random rng = Random();
+    uint64_t seed = 1;         // Seed of this session (Stored in replays)
+    long long tick = 0;        // Steps since reset() (Replay time base)
+    int stepCarry = 0;         // Game tick fraction carried to the next step (In 1/tickRate)
+
+    EventScheduler scheduler;
+    long long lastSpawnTick = 0; // Last regular enemy spawn
+    long long lastHitTick = 0;   // Last bullet hit (Or no-hit penalty)
+    int enemySpawnEvent = -1;    // Pending regular spawn (Moved when the level changes)
+
+    // Per-tick scratch: collision broad-phase, and the arena of the contact lists
+    SpatialGrid enemyGrid;
+    FrameArena tickArena;
+    ArenaArray<HitPair> hitPairs[MAX_JOB_CHUNKS];
+    ArenaArray<Effect> effects;  // Of the last tick (Gone with the next arena reset)
+    bool profiled = false;       // Records PROFILE_UPDATE (Only one world may, the window's)
+
+    void allocate();
+    void reset(uint64_t seed);
+    void step(const InputIntent& intent);
+    void observe(GameSnapshot& snapshot) const;
+    void save(SaveState& state) const; // Exact copy, see SAVE STATES
+    void load(const SaveState& state);
+
+    // Game rules (Called through step())
+    TickCommand tickCommand(const InputIntent& intent) const;
+    void resetGame();
+    void update(const TickCommand& command);
+    void fireBullet();
+    void spawnEnemy(int type);
+    int stepGameTicks();
+    void snapPreviousState();
+
+    // Event scheduler
+    int enemySpawnPeriod() const;
+    void wheelInsert(int index);
+    int scheduleEvent(EventKind kind, long long due);
+    void cancelEvent(int index);
+    void schedulerClear();
+    void runEvent(TimedEvent& event);
+    void runDueEvents();
+    void scheduleGameEvents();
+};
+
+World world; // The game in the window (And of --headless / --replay runs)
+
+// Spawn an enemy of the given archetype (-1 = weighted random) at a random x along the top
+// (Random numbers in a fixed order: x, speed step, then the type)
+void World::spawnEnemy(int type) {
+    float x = randomInt(rng, playfield.width - 40) + randomInt(rng, 20);
+    int speedStep = randomInt(rng, SPEED_STEPS);
+    if (type < 0 || type >= ENEMY_ARCHETYPES) {
+        int totalWeight = 0;
+        for (const EnemyArchetype& kind : enemyArchetypes) totalWeight += kind.spawnWeight;
+        int roll = randomInt(rng, totalWeight);
+        type = 0;
+        while (roll >= enemyArchetypes[type].spawnWeight) {
+            roll -= enemyArchetypes[type].spawnWeight;
+            type++;
+        }
+    }
+
+    const EnemyArchetype& kind = enemyArchetypes[type];
+    float speed = kind.speedMin + (kind.speedMax - kind.speedMin) * speedStep / (SPEED_STEPS - 1)
+        + currentLevel * kind.speedPerLevel;
+    entityAdd(enemies, x, playfield.height, speed, type);
+}
+
+// Ticks between regular enemy spawns (--spawn-rate=N forces N + 1)
+int World::enemySpawnPeriod() const {
+    return forcedSpawnRate > 0 ? forcedSpawnRate + 1 : difficultyLevels[currentLevel - 1].spawnPeriod;
+}
+
+int powerUpSpawnPeriod() {
+    return powerUpPeriod > 0 ? powerUpPeriod : POWER_UP_PERIOD;
+}
+
+void World::wheelInsert(int index) {
+    TimedEvent& event = scheduler.events[index];
+    int slot = (int)(event.due & (WHEEL_SLOTS - 1));
+    event.next = -1;
+    if (scheduler.head[slot][event.kind] < 0) scheduler.head[slot][event.kind] = index;
+    else scheduler.events[scheduler.tail[slot][event.kind]].next = index;
+    scheduler.tail[slot][event.kind] = index;
+    scheduler.occupied[slot / 64] |= 1ULL << (slot % 64);
+}
+
+// Queue an event (O(1) within the wheel, O(log n) beyond it). Returns its index or -1.
+int World::scheduleEvent(EventKind kind, long long due) {
+    if (scheduler.freeList < 0) {
+        scheduler.dropped++;
+        return -1;
+    }
+    int index = scheduler.freeList;
+    TimedEvent& event = scheduler.events[index];
+    scheduler.freeList = event.next;
+
+    // Never in the past; a kind that already ran this tick (Or anything between ticks) runs next tick
+    if (due <= scheduler.now && kind <= scheduler.running) due = scheduler.now + 1;
+    else if (due < scheduler.now) due = scheduler.now;
+    event.due = due;
+    event.kind = kind;
+    event.cancelled = false;
+    event.count = 1;
+    event.archetype = -1;
+    event.interval = 0;
+    if (due - scheduler.now < WHEEL_SLOTS) {
+        wheelInsert(index);
+    }
+    else {
+        scheduler.later.push_back(index);
+        std::push_heap(scheduler.later.begin(), scheduler.later.end(), LaterFirst{ scheduler });
+    }
+    return index;
+}
+
+// Drop a pending event (It is skipped and recycled when its slot comes up)
+void World::cancelEvent(int index) {
+    if (index >= 0) scheduler.events[index].cancelled = true;
+}
+
+void World::schedulerClear() {
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        scheduler.events[i].next = i + 1 < MAX_EVENTS ? i + 1 : -1;
+    }
+    scheduler.freeList = 0;
+    for (int s = 0; s < WHEEL_SLOTS; s++) {
+        for (int k = 0; k < EVENT_KINDS; k++) {
+            scheduler.head[s][k] = scheduler.tail[s][k] = -1;
+        }
+    }
+    memset(scheduler.occupied, 0, sizeof(scheduler.occupied));
+    scheduler.later.clear();
+    scheduler.now = 0;
+    scheduler.running = EVENT_KINDS;
+}
+
+void World::runEvent(TimedEvent& event) {
+    long long now = scheduler.now;
+    switch (event.kind) {
+    case EVENT_LEVEL_UP:
+        // MODIFIED: Increase difficulty steeply
+        currentLevel++;
+        if (currentLevel < MAX_LEVEL) scheduleEvent(EVENT_LEVEL_UP, now + LEVEL_TICKS);
+
+        // The regular spawn follows the new period, counted from the last spawn
+        cancelEvent(enemySpawnEvent);
+        enemySpawnEvent = scheduleEvent(EVENT_ENEMY_SPAWN, lastSpawnTick + enemySpawnPeriod());
+        break;
+    case EVENT_NO_HIT_PENALTY:
+        // Hits only move lastHitTick, so the penalty checks it here and re-arms itself
+        if (now - lastHitTick >= NO_HIT_TICKS) {
+            if (player.lives > 0) {
+                player.lives--;
+                lastHitTick = now;
+                effects.push_back({ EFFECT_PLAYER_HIT, 0, player.x, player.y });
+            }
+            if (player.lives <= 0) {
+                gameState = GAME_OVER;
+            }
+        }
+        scheduleEvent(EVENT_NO_HIT_PENALTY, lastHitTick + NO_HIT_TICKS);
+        break;
+    case EVENT_ENEMY_SPAWN:
+        for (int n = 0; n < difficultyLevels[currentLevel - 1].spawnCount * spawnBurst; n++) {
+            // MODIFIED: Enemy speed increases with level (Per-archetype speed curve)
+            spawnEnemy(-1);
+        }
+        lastSpawnTick = now;
+        enemySpawnEvent = scheduleEvent(EVENT_ENEMY_SPAWN, now + enemySpawnPeriod());
+        break;
+    case EVENT_POWER_UP_SPAWN:
+        entityAdd(powerUps, randomInt(rng, playfield.width - 40) + 20, playfield.height, 1.5, 0);
+        scheduleEvent(EVENT_POWER_UP_SPAWN, now + powerUpSpawnPeriod());
+        break;
+    case EVENT_WAVE: {
+        int spawns = event.interval > 0 ? 1 : event.count;
+        for (int n = 0; n < spawns; n++) {
+            spawnEnemy(event.archetype);
+        }
+        if (event.count > spawns) {
+            int index = scheduleEvent(EVENT_WAVE, now + event.interval);
+            if (index >= 0) {
+                TimedEvent& rest = scheduler.events[index];
+                rest.count = event.count - spawns;
+                rest.archetype = event.archetype;
+                rest.interval = event.interval;
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Advance one tick and run every event due on it (Kinds in EventKind order)
+void World::runDueEvents() {
+    long long now = ++scheduler.now;
+    while (!scheduler.later.empty() && scheduler.events[scheduler.later.front()].due - now < WHEEL_SLOTS) {
+        std::pop_heap(scheduler.later.begin(), scheduler.later.end(), LaterFirst{ scheduler });
+        wheelInsert(scheduler.later.back());
+        scheduler.later.pop_back();
+    }
+
+    int slot = (int)(now & (WHEEL_SLOTS - 1));
+    for (int k = 0; k < EVENT_KINDS; k++) {
+        scheduler.running = k;
+        while (scheduler.head[slot][k] >= 0) {
+            int index = scheduler.head[slot][k];
+            TimedEvent& event = scheduler.events[index];
+            scheduler.head[slot][k] = event.next;
+            if (!event.cancelled) runEvent(event);
+            event.next = scheduler.freeList;
+            scheduler.freeList = index;
+        }
+    }
+    scheduler.occupied[slot / 64] &= ~(1ULL << (slot % 64));
+    scheduler.running = EVENT_KINDS;
+}
+
+// Timeline of a new game
+void World::scheduleGameEvents() {
+    schedulerClear();
+    lastSpawnTick = 0;
+    lastHitTick = 0;
+    if (currentLevel < MAX_LEVEL) scheduleEvent(EVENT_LEVEL_UP, LEVEL_TICKS);
+    scheduleEvent(EVENT_NO_HIT_PENALTY, NO_HIT_TICKS);
+    enemySpawnEvent = scheduleEvent(EVENT_ENEMY_SPAWN, enemySpawnPeriod());
+    scheduleEvent(EVENT_POWER_UP_SPAWN, powerUpSpawnPeriod());
+    for (const WaveScript& wave : waveScripts) {
+        int index = scheduleEvent(EVENT_WAVE, std::max(1LL, wave.tick));
+        if (index < 0) continue;
+        scheduler.events[index].count = wave.count;
+        scheduler.events[index].archetype = wave.archetype;
+        scheduler.events[index].interval = wave.interval;
+    }
+}
+
+// Read wave scripts: one "tick count archetype interval" line per wave, '#' starts a comment
+bool loadWaveScripts(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot read wave script '%s'\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        WaveScript wave;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%lld %d %d %d", &wave.tick, &wave.count, &wave.archetype, &wave.interval) == 4 && wave.count > 0) {
+            wave.interval = std::max(0, wave.interval);
+            waveScripts.push_back(wave);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// === FIXED TIMESTEP ===
+// The simulation always advances in steps of tickSeconds, driven by a
+// high-resolution clock. Rendering happens as often as GLUT lets it and
+// interpolates between the state before and after the last tick.
+// The game rules are written for 60 Hz "game ticks" (Speeds in units per game tick,
+// events, cooldowns and waves in game ticks). --tick-rate=HZ steps the simulation at a
+// different rate: distances are scaled by stepScale and each step runs the events of
+// every game tick it covers, so the game plays the same on a coarser or finer clock.
+const int GAME_TICK_RATE = 60;
+const int MIN_TICK_RATE = 10, MAX_TICK_RATE = 240;
+const int MAX_TICKS_PER_FRAME = 5; // Catch-up limit, older backlog is dropped
+
+int tickRate = GAME_TICK_RATE;            // Steps per second (Stored in replays)
+double tickSeconds = 1.0 / GAME_TICK_RATE;
+float stepScale = 1;                      // Game ticks per step
+
+void setTickRate(int rate) {
+    tickRate = std::max(MIN_TICK_RATE, std::min(MAX_TICK_RATE, rate));
+    tickSeconds = 1.0 / tickRate;
+    stepScale = (float)GAME_TICK_RATE / tickRate;
+}
+
+// Whole game ticks the next step covers (Exact: 30 Hz gives 2, 120 Hz alternates 0 and 1)
+int World::stepGameTicks() {
+    stepCarry += GAME_TICK_RATE;
+    int ticks = stepCarry / tickRate;
+    stepCarry -= ticks * tickRate;
+    return ticks;
+}
+
+// Remember the current state as the start point for interpolation
+void World::snapPreviousState() {
+    player.prevX = player.x;
+    player.prevY = player.y;
+    prevStarOffset = starOffset;
+    std::copy(bullets.y.begin(), bullets.y.begin() + bullets.count, bullets.prevY.begin());
+    std::copy(enemies.y.begin(), enemies.y.begin() + enemies.count, enemies.prevY.begin());
+    std::copy(powerUps.y.begin(), powerUps.y.begin() + powerUps.count, powerUps.prevY.begin());
+}
+
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// === GAME SNAPSHOTS ===
+// The simulation thread copies everything display() needs into a snapshot
+// after each batch of ticks. Snapshots are passed through a triple buffer, so
+// the writer and the reader never wait on each other and the reader always
+// gets the most recent complete state.
+struct ObjectView {
+    std::vector<float> x, y, prevY;
+    std::vector<int> type;
+    int count = 0;
+    long long exhausted = 0;
+};
+
+struct GameSnapshot {
+    GameState state = MENU;
+    Player player = Player();
+    int level = 1;
+    float starOffset = 0, prevStarOffset = 0;
+    ObjectView bullets, enemies, powerUps;
+    std::chrono::steady_clock::time_point tickTime; // When the last tick was due (For interpolation)
+    std::chrono::steady_clock::time_point inputTime; // Newest input event applied so far
+    uint32_t inputApplied = 0; // Input queue position drained into the ticks above
+};
+
+const int SNAPSHOT_FRESH = 4; // Set in middle when the writer published something new
+
+struct SnapshotBuffer {
+    GameSnapshot slots[3];
+    std::atomic<int> middle{ 1 }; // Slot index shared by both sides (| SNAPSHOT_FRESH)
+    int back = 0;                 // Owned by the writer
+    int front = 2;                // Owned by the reader
+} snapshots;
+
+void reserveObjectView(ObjectView& view, int capacity) {
+    view.x.assign(capacity, 0);
+    view.y.assign(capacity, 0);
+    view.prevY.assign(capacity, 0);
+    view.type.assign(capacity, 0);
+}
+
+void copyObjects(ObjectView& view, const EntityStore& store) {
+    view.count = store.count;
+    view.exhausted = store.exhausted;
+    std::copy(store.x.begin(), store.x.begin() + store.count, view.x.begin());
+    std::copy(store.y.begin(), store.y.begin() + store.count, view.y.begin());
+    std::copy(store.prevY.begin(), store.prevY.begin() + store.count, view.prevY.begin());
+    std::copy(store.type.begin(), store.type.begin() + store.count, view.type.begin());
+}
+
+// Size the views of a snapshot for full pools (Startup only, observe() never allocates)
+void reserveSnapshot(GameSnapshot& snapshot) {
+    reserveObjectView(snapshot.bullets, poolConfig.bullets);
+    reserveObjectView(snapshot.enemies, poolConfig.enemies);
+    reserveObjectView(snapshot.powerUps, poolConfig.powerUps);
+}
+
+// Copy the visible state of the world (Timestamps are left to the caller)
+void World::observe(GameSnapshot& snapshot) const {
+    snapshot.state = gameState;
+    snapshot.player = player;
+    snapshot.level = currentLevel;
+    snapshot.starOffset = starOffset;
+    snapshot.prevStarOffset = prevStarOffset;
+    copyObjects(snapshot.bullets, bullets);
+    copyObjects(snapshot.enemies, enemies);
+    copyObjects(snapshot.powerUps, powerUps);
+}
+
+std::chrono::steady_clock::time_point newestInputTime; // Simulation side, set by drainInput()
+uint32_t appliedInput = 0; // Input events drained so far (Simulation side, the queue's read position)
+
+// Writer side: fill the back slot from the game state and hand it over
+void publishSnapshot(std::chrono::steady_clock::time_point tickTime) {
+    GameSnapshot& snapshot = snapshots.slots[snapshots.back];
+    world.observe(snapshot);
+    snapshot.tickTime = tickTime;
+    snapshot.inputTime = newestInputTime;
+    snapshot.inputApplied = appliedInput;
+
+    snapshots.back = snapshots.middle.exchange(snapshots.back | SNAPSHOT_FRESH, std::memory_order_acq_rel) & 3;
+}
+
+// Reader side: swap in the newest snapshot if there is one
+const GameSnapshot& latestSnapshot() {
+    if (snapshots.middle.load(std::memory_order_acquire) & SNAPSHOT_FRESH) {
+        snapshots.front = snapshots.middle.exchange(snapshots.front, std::memory_order_acq_rel) & 3;
+    }
+    return snapshots.slots[snapshots.front];
+}
+
+// === INPUT ===
+// Keyboard callbacks only turn key transitions into timestamped raw events; they never
+// touch the game. Once per tick the simulation thread folds the queued events into the
+// keys held at the end of the tick plus the SPACE presses during it (An InputIntent),
+// which becomes the tick's TickCommand for update(). Replays record intents, so playback
+// goes through exactly the same command path as live input.
+// Single producer (GLUT thread), single consumer (Simulation thread), lock-free.
+enum InputKey { KEY_A, KEY_D, KEY_W, KEY_S, KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN, KEY_SPACE };
+
+struct InputEvent {
+    unsigned char key; // InputKey (Each physical key separately: releasing A does not stop LEFT)
+    bool down;
+    std::chrono::steady_clock::time_point time; // When it was pushed (Input latency)
+};
+
+const int INPUT_QUEUE_SIZE = 256; // Power of two
+
+struct InputQueue {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    std::atomic<uint32_t> head{ 0 }; // Next slot to write
+    std::atomic<uint32_t> tail{ 0 }; // Next slot to read
+    long long dropped = 0;           // Events lost to a full queue
+} inputQueue;
+
+void pushInput(InputKey key, bool down) {
+    uint32_t head = inputQueue.head.load(std::memory_order_relaxed);
+    if (head - inputQueue.tail.load(std::memory_order_acquire) == INPUT_QUEUE_SIZE) {
+        inputQueue.dropped++;
+        return;
+    }
+    inputQueue.events[head & (INPUT_QUEUE_SIZE - 1)] = { (unsigned char)key, down, std::chrono::steady_clock::now() };
+    inputQueue.head.store(head + 1, std::memory_order_release);
+}
+
+bool popInput(InputEvent& event) {
+    uint32_t tail = inputQueue.tail.load(std::memory_order_relaxed);
+    if (tail == inputQueue.head.load(std::memory_order_acquire)) return false;
+    event = inputQueue.events[tail & (INPUT_QUEUE_SIZE - 1)];
+    inputQueue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// Intent bits (Also the replay key bits)
+const unsigned char INTENT_LEFT = 1, INTENT_RIGHT = 2, INTENT_UP = 4, INTENT_DOWN = 8, INTENT_FIRE = 16;
+
+// One tick of input: what is held at its end, and how often SPACE went down during it
+struct InputIntent {
+    unsigned char bits = 0;
+    int presses = 0;
+};
+
+// What update() does with it
+struct TickCommand {
+    unsigned char move = 0; // INTENT_LEFT | INTENT_RIGHT | INTENT_UP | INTENT_DOWN
+    bool start = false;     // SPACE outside PLAYING: (re)start the game
+    int presses = 0;        // Presses left for firing
+    bool fireHeld = false;  // SPACE held: autofire at the rate limit
+};
+
+uint32_t heldKeys = 0; // Simulation side: one bit per InputKey
+
+// Drain the queue into this tick's intent (A down for a key already held is a repeat)
+InputIntent drainInput() {
+    InputEvent event;
+    InputIntent intent;
+    while (popInput(event)) {
+        uint32_t bit = 1u << event.key;
+        if (event.down && event.key == KEY_SPACE && !(heldKeys & bit)) intent.presses++;
+        heldKeys = event.down ? heldKeys | bit : heldKeys & ~bit;
+        newestInputTime = std::max(newestInputTime, event.time);
+        appliedInput++;
+    }
+    auto held = [](InputKey a, InputKey b) { return (heldKeys & (1u << a | 1u << b)) != 0; };
+    intent.bits = (held(KEY_A, KEY_LEFT) ? INTENT_LEFT : 0) | (held(KEY_D, KEY_RIGHT) ? INTENT_RIGHT : 0)
+        | (held(KEY_W, KEY_UP) ? INTENT_UP : 0) | (held(KEY_S, KEY_DOWN) ? INTENT_DOWN : 0)
+        | (heldKeys & (1u << KEY_SPACE) ? INTENT_FIRE : 0);
+    return intent;
+}
+
+// === SIMD KERNELS ===
+// Per-tick sweeps over the entity columns. Every kernel has a scalar reference
+// version; selectSimdKernels() picks the widest one the CPU supports at startup.
+//   integrate:    y[i] += direction * speed[i]
+//   cullOutside:  out[i] = y[i] < minY || y[i] > maxY, returns the number flagged
+//   withinRadius: out[i] = (x[i] - px)^2 + (y[i] - py)^2 < r2, returns the number flagged
+struct SimdKernels {
+    const char* name;
+    void (*integrate)(float* y, const float* speed, int n, float direction);
+    int (*cullOutside)(const float* y, int n, float minY, float maxY, unsigned char* out);
+    int (*withinRadius)(const float* x, const float* y, int n, float px, float py, float r2, unsigned char* out);
+};
+
+void integrateScalar(float* y, const float* speed, int n, float direction) {
+    for (int i = 0; i < n; i++) {
+        y[i] += direction * speed[i];
+    }
+}
+
+int cullOutsideScalar(const float* y, int n, float minY, float maxY, unsigned char* out) {
+    int flagged = 0;
+    for (int i = 0; i < n; i++) {
+        out[i] = y[i] < minY || y[i] > maxY;
+        flagged += out[i];
+    }
+    return flagged;
+}
+
+int withinRadiusScalar(const float* x, const float* y, int n, float px, float py, float r2, unsigned char* out) {
+    int flagged = 0;
+    for (int i = 0; i < n; i++) {
+        float dx = x[i] - px;
+        float dy = y[i] - py;
+        out[i] = dx * dx + dy * dy < r2;
+        flagged += out[i];
+    }
+    return flagged;
+}
+
+const SimdKernels scalarKernels = { "scalar", integrateScalar, cullOutsideScalar, withinRadiusScalar };
+
+// Expand a compare bitmask into one byte per lane
+int storeMask(int bits, int lanes, unsigned char* out) {
+    int flagged = 0;
+    for (int k = 0; k < lanes; k++) {
+        out[k] = (bits >> k) & 1;
+        flagged += out[k];
+    }
+    return flagged;
+}
+
+#if SD_SSE2
+void integrateSSE2(float* y, const float* speed, int n, float direction) {
+    __m128 dir = _mm_set1_ps(direction);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(dir, _mm_loadu_ps(speed + i)));
+        _mm_storeu_ps(y + i, v);
+    }
+    integrateScalar(y + i, speed + i, n - i, direction);
+}
+
+int cullOutsideSSE2(const float* y, int n, float minY, float maxY, unsigned char* out) {
+    __m128 lo = _mm_set1_ps(minY), hi = _mm_set1_ps(maxY);
+    int flagged = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(y + i);
+        __m128 outside = _mm_or_ps(_mm_cmplt_ps(v, lo), _mm_cmpgt_ps(v, hi));
+        flagged += storeMask(_mm_movemask_ps(outside), 4, out + i);
+    }
+    return flagged + cullOutsideScalar(y + i, n - i, minY, maxY, out + i);
+}
+
+int withinRadiusSSE2(const float* x, const float* y, int n, float px, float py, float r2, unsigned char* out) {
+    __m128 cx = _mm_set1_ps(px), cy = _mm_set1_ps(py), limit = _mm_set1_ps(r2);
+    int flagged = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), cy);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        flagged += storeMask(_mm_movemask_ps(_mm_cmplt_ps(d2, limit)), 4, out + i);
+    }
+    return flagged + withinRadiusScalar(x + i, y + i, n - i, px, py, r2, out + i);
+}
+
+const SimdKernels sse2Kernels = { "sse2", integrateSSE2, cullOutsideSSE2, withinRadiusSSE2 };
+#endif
+
+#if SD_AVX2
+SD_TARGET_AVX2 void integrateAVX2(float* y, const float* speed, int n, float direction) {
+    __m256 dir = _mm256_set1_ps(direction);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(dir, _mm256_loadu_ps(speed + i)));
+        _mm256_storeu_ps(y + i, v);
+    }
+    integrateScalar(y + i, speed + i, n - i, direction);
+}
+
+SD_TARGET_AVX2 int cullOutsideAVX2(const float* y, int n, float minY, float maxY, unsigned char* out) {
+    __m256 lo = _mm256_set1_ps(minY), hi = _mm256_set1_ps(maxY);
+    int flagged = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(y + i);
+        __m256 outside = _mm256_or_ps(_mm256_cmp_ps(v, lo, _CMP_LT_OQ), _mm256_cmp_ps(v, hi, _CMP_GT_OQ));
+        flagged += storeMask(_mm256_movemask_ps(outside), 8, out + i);
+    }
+    return flagged + cullOutsideScalar(y + i, n - i, minY, maxY, out + i);
+}
+
+SD_TARGET_AVX2 int withinRadiusAVX2(const float* x, const float* y, int n, float px, float py, float r2, unsigned char* out) {
+    __m256 cx = _mm256_set1_ps(px), cy = _mm256_set1_ps(py), limit = _mm256_set1_ps(r2);
+    int flagged = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), cy);
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        flagged += storeMask(_mm256_movemask_ps(_mm256_cmp_ps(d2, limit, _CMP_LT_OQ)), 8, out + i);
+    }
+    return flagged + withinRadiusScalar(x + i, y + i, n - i, px, py, r2, out + i);
+}
+
+const SimdKernels avx2Kernels = { "avx2", integrateAVX2, cullOutsideAVX2, withinRadiusAVX2 };
+#endif
+
+#if SD_NEON
+// NEON has no movemask, so lane masks are stored and narrowed to bytes
+int storeMaskNEON(uint32x4_t mask, unsigned char* out) {
+    uint32_t lanes[4];
+    vst1q_u32(lanes, mask);
+    int flagged = 0;
+    for (int k = 0; k < 4; k++) {
+        out[k] = lanes[k] != 0;
+        flagged += out[k];
+    }
+    return flagged;
+}
+
+void integrateNEON(float* y, const float* speed, int n, float direction) {
+    float32x4_t dir = vdupq_n_f32(direction);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(y + i, vaddq_f32(vld1q_f32(y + i), vmulq_f32(dir, vld1q_f32(speed + i))));
+    }
+    integrateScalar(y + i, speed + i, n - i, direction);
+}
+
+int cullOutsideNEON(const float* y, int n, float minY, float maxY, unsigned char* out) {
+    float32x4_t lo = vdupq_n_f32(minY), hi = vdupq_n_f32(maxY);
+    int flagged = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(y + i);
+        flagged += storeMaskNEON(vorrq_u32(vcltq_f32(v, lo), vcgtq_f32(v, hi)), out + i);
+    }
+    return flagged + cullOutsideScalar(y + i, n - i, minY, maxY, out + i);
+}
+
+int withinRadiusNEON(const float* x, const float* y, int n, float px, float py, float r2, unsigned char* out) {
+    float32x4_t cx = vdupq_n_f32(px), cy = vdupq_n_f32(py), limit = vdupq_n_f32(r2);
+    int flagged = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t dx = vsubq_f32(vld1q_f32(x + i), cx);
+        float32x4_t dy = vsubq_f32(vld1q_f32(y + i), cy);
+        float32x4_t d2 = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+        flagged += storeMaskNEON(vcltq_f32(d2, limit), out + i);
+    }
+    return flagged + withinRadiusScalar(x + i, y + i, n - i, px, py, r2, out + i);
+}
+
+const SimdKernels neonKernels = { "neon", integrateNEON, cullOutsideNEON, withinRadiusNEON };
+#endif
+
+SimdKernels simd = scalarKernels;
+
+bool cpuHasAvx2() {
+#if SD_AVX2 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif SD_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Pick the kernels for this CPU (A name from --simd=... forces a specific path)
+void selectSimdKernels(const char* forced) {
+    std::vector<const SimdKernels*> available = { &scalarKernels };
+#if SD_SSE2
+    available.push_back(&sse2Kernels);
+#endif
+#if SD_AVX2
+    if (cpuHasAvx2()) available.push_back(&avx2Kernels);
+#endif
+#if SD_NEON
+    available.push_back(&neonKernels);
+#endif
+
+    simd = *available.back();
+    if (forced) {
+        for (const SimdKernels* kernels : available) {
+            if (strcmp(kernels->name, forced) == 0) simd = *kernels;
+        }
+    }
+}
+
+// Compare the selected kernels against the scalar reference (--simd-check)
+int checkSimdKernels() {
+    int mismatches = 0;
+    Random rng;
+    seedRandom(rng, 12345);
+    for (int n = 0; n < 100; n++) {
+        std::vector<float> x(n), y(n), speed(n), yRef;
+        std::vector<unsigned char> out(n), outRef(n);
+        for (int i = 0; i < n; i++) {
+            x[i] = randomInt(rng, playfield.width) + randomInt(rng, 100) / 100.0f;
+            y[i] = randomInt(rng, playfield.height + 100) - 50 + randomInt(rng, 100) / 100.0f;
+            speed[i] = 1.5f + randomInt(rng, 8) * 0.5f;
+        }
+
+        yRef = y;
+        simd.integrate(y.data(), speed.data(), n, -1);
+        integrateScalar(yRef.data(), speed.data(), n, -1);
+        if (y != yRef) mismatches++;
+
+        int flagged = simd.cullOutside(y.data(), n, -30, playfield.height, out.data());
+        int flaggedRef = cullOutsideScalar(y.data(), n, -30, playfield.height, outRef.data());
+        if (flagged != flaggedRef || out != outRef) mismatches++;
+
+        flagged = simd.withinRadius(x.data(), y.data(), n, playfield.width / 2, playfield.height / 2, 200 * 200, out.data());
+        flaggedRef = withinRadiusScalar(x.data(), y.data(), n, playfield.width / 2, playfield.height / 2, 200 * 200, outRef.data());
+        if (flagged != flaggedRef || out != outRef) mismatches++;
+    }
+    printf("SIMD kernels '%s': %d mismatches against scalar\n", simd.name, mismatches);
+    return mismatches;
+}
+
+// Reset all game variables for a new game (Used by reset() and every restart)
+void World::resetGame() {
+    player.x = playfield.width / 2;
+    player.y = 50;
+    player.size = 20;
+    player.speed = 5.0f;
+    player.lives = 3;
+    player.score = 0;
+    entityClear(bullets);
+    entityClear(enemies);
+    entityClear(powerUps);
+
+    starOffset = 0;
+    currentLevel = std::max(1, std::min(MAX_LEVEL, startLevel));
+    playerShape = 0;
+    fireCooldown = 0;
+    fireQueued = false;
+    stepCarry = 0;
+    scheduleGameEvents();
+    snapPreviousState();
+}
+
+// Shoot bullet (From the ship's nose)
+void World::fireBullet() {
+    entityAdd(bullets, player.x, player.y + player.size, 10.0, 0);
+}
+
+// === GL EXTENSIONS ===
+// Entry points above OpenGL 1.1 are loaded at runtime, so the game still starts
+// (with the feature switched off) on drivers that do not have them.
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#endif
+
+struct GLExtensions {
+    int major = 1, minor = 1; // Context version
+
+    // Timer queries (GL 3.3 or ARB/EXT_timer_query)
+    bool timerQuery = false;
+    void (APIENTRY* genQueries)(GLsizei n, GLuint* ids) = NULL;
+    void (APIENTRY* beginQuery)(GLenum target, GLuint id) = NULL;
+    void (APIENTRY* endQuery)(GLenum target) = NULL;
+    void (APIENTRY* getQueryObjectiv)(GLuint id, GLenum pname, GLint* params) = NULL;
+    void (APIENTRY* getQueryObjectui64v)(GLuint id, GLenum pname, uint64_t* params) = NULL;
+
+    // Vertex buffer objects (GL 1.5 or ARB_vertex_buffer_object)
+    bool vertexBuffers = false;
+    void (APIENTRY* genBuffers)(GLsizei n, GLuint* buffers) = NULL;
+    void (APIENTRY* bindBuffer)(GLenum target, GLuint buffer) = NULL;
+    void (APIENTRY* bufferData)(GLenum target, ptrdiff_t size, const void* data, GLenum usage) = NULL;
+    void (APIENTRY* bufferSubData)(GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data) = NULL;
+
+    // GLSL programs and generic vertex attributes (GL 2.0)
+    bool shaders = false;
+    GLuint (APIENTRY* createShader)(GLenum type) = NULL;
+    void (APIENTRY* shaderSource)(GLuint shader, GLsizei count, const char* const* strings, const GLint* lengths) = NULL;
+    void (APIENTRY* compileShader)(GLuint shader) = NULL;
+    void (APIENTRY* getShaderiv)(GLuint shader, GLenum pname, GLint* params) = NULL;
+    void (APIENTRY* getShaderInfoLog)(GLuint shader, GLsizei size, GLsizei* length, char* log) = NULL;
+    GLuint (APIENTRY* createProgram)() = NULL;
+    void (APIENTRY* attachShader)(GLuint program, GLuint shader) = NULL;
+    void (APIENTRY* bindAttribLocation)(GLuint program, GLuint index, const char* name) = NULL;
+    void (APIENTRY* linkProgram)(GLuint program) = NULL;
+    void (APIENTRY* getProgramiv)(GLuint program, GLenum pname, GLint* params) = NULL;
+    void (APIENTRY* getProgramInfoLog)(GLuint program, GLsizei size, GLsizei* length, char* log) = NULL;
+    void (APIENTRY* useProgram)(GLuint program) = NULL;
+    GLint (APIENTRY* getUniformLocation)(GLuint program, const char* name) = NULL;
+    void (APIENTRY* uniform1f)(GLint location, GLfloat x) = NULL;
+    void (APIENTRY* uniform4f)(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) = NULL;
+    void (APIENTRY* vertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) = NULL;
+    void (APIENTRY* enableVertexAttribArray)(GLuint index) = NULL;
+    void (APIENTRY* disableVertexAttribArray)(GLuint index) = NULL;
+
+    // Instanced drawing (GL 3.3, or GL 3.0 with ARB_instanced_arrays; shaders use GLSL 1.30)
+    bool instancing = false;
+    void (APIENTRY* vertexAttribDivisor)(GLuint index, GLuint divisor) = NULL;
+    void (APIENTRY* drawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instances) = NULL;
+
+    // Framebuffer objects with a texture colour attachment (GL 3.0 or ARB/EXT_framebuffer_object)
+    bool framebuffers = false;
+    void (APIENTRY* genFramebuffers)(GLsizei n, GLuint* ids) = NULL;
+    void (APIENTRY* bindFramebuffer)(GLenum target, GLuint framebuffer) = NULL;
+    void (APIENTRY* framebufferTexture2D)(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level) = NULL;
+    GLenum (APIENTRY* checkFramebufferStatus)(GLenum target) = NULL;
+} glext;
+
+// Whole-word search in a space-separated extension list
+bool hasExtension(const char* extensions, const char* name) {
+    if (!extensions) return false;
+    size_t length = strlen(name);
+    for (const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) return true;
+    }
+    return false;
+}
+
+bool hasGLExtension(const char* name) {
+    return hasExtension((const char*)glGetString(GL_EXTENSIONS), name);
+}
+
+// Look up one entry point (Only freeglut exposes a portable loader, classic GLUT gets none)
+template <typename Proc>
+bool loadGLProc(Proc& proc, const char* name) {
+#ifdef FREEGLUT
+    proc = (Proc)glutGetProcAddress(name);
+#else
+    proc = NULL;
+#endif
+    return proc != NULL;
+}
+
+// Needs a current GL context (Called from init)
+void loadGLExtensions() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version) sscanf(version, "%d.%d", &glext.major, &glext.minor);
+    bool gl33 = glext.major > 3 || (glext.major == 3 && glext.minor >= 3);
+
+    if (gl33 || hasGLExtension("GL_ARB_timer_query") || hasGLExtension("GL_EXT_timer_query")) {
+        glext.timerQuery = loadGLProc(glext.genQueries, "glGenQueries")
+            && loadGLProc(glext.beginQuery, "glBeginQuery")
+            && loadGLProc(glext.endQuery, "glEndQuery")
+            && loadGLProc(glext.getQueryObjectiv, "glGetQueryObjectiv")
+            && (loadGLProc(glext.getQueryObjectui64v, "glGetQueryObjectui64v")
+                || loadGLProc(glext.getQueryObjectui64v, "glGetQueryObjectui64vEXT"));
+    }
+
+    bool gl15 = glext.major > 1 || glext.minor >= 5;
+    if (gl15) {
+        glext.vertexBuffers = loadGLProc(glext.genBuffers, "glGenBuffers")
+            && loadGLProc(glext.bindBuffer, "glBindBuffer")
+            && loadGLProc(glext.bufferData, "glBufferData")
+            && loadGLProc(glext.bufferSubData, "glBufferSubData");
+    }
+    else if (hasGLExtension("GL_ARB_vertex_buffer_object")) {
+        glext.vertexBuffers = loadGLProc(glext.genBuffers, "glGenBuffersARB")
+            && loadGLProc(glext.bindBuffer, "glBindBufferARB")
+            && loadGLProc(glext.bufferData, "glBufferDataARB")
+            && loadGLProc(glext.bufferSubData, "glBufferSubDataARB");
+    }
+
+    if (glext.major >= 2) {
+        glext.shaders = loadGLProc(glext.createShader, "glCreateShader")
+            && loadGLProc(glext.shaderSource, "glShaderSource")
+            && loadGLProc(glext.compileShader, "glCompileShader")
+            && loadGLProc(glext.getShaderiv, "glGetShaderiv")
+            && loadGLProc(glext.getShaderInfoLog, "glGetShaderInfoLog")
+            && loadGLProc(glext.createProgram, "glCreateProgram")
+            && loadGLProc(glext.attachShader, "glAttachShader")
+            && loadGLProc(glext.bindAttribLocation, "glBindAttribLocation")
+            && loadGLProc(glext.linkProgram, "glLinkProgram")
+            && loadGLProc(glext.getProgramiv, "glGetProgramiv")
+            && loadGLProc(glext.getProgramInfoLog, "glGetProgramInfoLog")
+            && loadGLProc(glext.useProgram, "glUseProgram")
+            && loadGLProc(glext.getUniformLocation, "glGetUniformLocation")
+            && loadGLProc(glext.uniform1f, "glUniform1f")
+            && loadGLProc(glext.uniform4f, "glUniform4f")
+            && loadGLProc(glext.vertexAttribPointer, "glVertexAttribPointer")
+            && loadGLProc(glext.enableVertexAttribArray, "glEnableVertexAttribArray")
+            && loadGLProc(glext.disableVertexAttribArray, "glDisableVertexAttribArray");
+    }
+
+    if (gl33) {
+        glext.instancing = loadGLProc(glext.vertexAttribDivisor, "glVertexAttribDivisor")
+            && loadGLProc(glext.drawArraysInstanced, "glDrawArraysInstanced");
+    }
+    else if (glext.major >= 3 && hasGLExtension("GL_ARB_instanced_arrays")) {
+        glext.instancing = loadGLProc(glext.vertexAttribDivisor, "glVertexAttribDivisorARB")
+            && loadGLProc(glext.drawArraysInstanced, "glDrawArraysInstanced");
+    }
+
+    if (glext.major >= 3 || hasGLExtension("GL_ARB_framebuffer_object")) {
+        glext.framebuffers = loadGLProc(glext.genFramebuffers, "glGenFramebuffers")
+            && loadGLProc(glext.bindFramebuffer, "glBindFramebuffer")
+            && loadGLProc(glext.framebufferTexture2D, "glFramebufferTexture2D")
+            && loadGLProc(glext.checkFramebufferStatus, "glCheckFramebufferStatus");
+    }
+    else if (hasGLExtension("GL_EXT_framebuffer_object")) {
+        glext.framebuffers = loadGLProc(glext.genFramebuffers, "glGenFramebuffersEXT")
+            && loadGLProc(glext.bindFramebuffer, "glBindFramebufferEXT")
+            && loadGLProc(glext.framebufferTexture2D, "glFramebufferTexture2DEXT")
+            && loadGLProc(glext.checkFramebufferStatus, "glCheckFramebufferStatusEXT");
+    }
+}
+
+// === PROFILER ===
+// ProfileScope measures the lifetime of a block and records it under a section.
+// Samples go into a lock-free ring per section (One writer each, the overlay reads),
+// so percentiles can be taken over the last few seconds at any time.
+enum ProfileSection {
+    PROFILE_FRAME,    // Time between two display() calls
+    PROFILE_UPDATE,   // One simulation tick
+    PROFILE_COLLISIONS, // Contact tests of a tick (Player, bullets, power-ups)
+    PROFILE_CLEANUP,  // Removing the killed and culled objects of a tick
+    PROFILE_RENDER,   // Whole display() on the CPU
+    PROFILE_STARS,
+    PROFILE_PLAYER,
+    PROFILE_BULLETS,
+    PROFILE_ENEMIES,
+    PROFILE_POWERUPS,
+    PROFILE_FLUSH,    // Submitting the batched geometry
+    PROFILE_PARTICLES,
+    PROFILE_HUD,
+    PROFILE_GPU,      // Whole frame on the GPU (GL_TIME_ELAPSED)
+    PROFILE_SECTION_COUNT
+};
+
+const char* profileSectionNames[PROFILE_SECTION_COUNT] = {
+    "frame", "update", "collisions", "cleanup", "render", "stars", "player", "bullets",
+    "enemies", "power-ups", "flush", "particles", "HUD", "GPU"
+};
+
+const int PROFILE_RING_SIZE = 4096;     // Power of two
+const uint32_t PROFILE_WINDOW_MS = 3000; // Percentiles cover this much history
+
+// Each sample packs (milliseconds since start << 32) | nanoseconds
+struct ProfileRing {
+    std::atomic<uint32_t> head{ 0 };
+    std::atomic<uint64_t> samples[PROFILE_RING_SIZE];
+    std::atomic<uint64_t> total{ 0 }; // Nanoseconds of every sample so far (Means over a run)
+};
+
+ProfileRing profileRings[PROFILE_SECTION_COUNT];
+const std::chrono::steady_clock::time_point profileEpoch = std::chrono::steady_clock::now();
+bool showProfiler = false; // Toggled with F3
+
+uint32_t profileMilliseconds() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - profileEpoch).count();
+}
+
+void profileRecord(ProfileSection section, uint64_t nanoseconds) {
+    ProfileRing& ring = profileRings[section];
+    uint32_t slot = ring.head.load(std::memory_order_relaxed);
+    uint64_t ns = std::min<uint64_t>(nanoseconds, 0xFFFFFFFFu);
+    ring.samples[slot & (PROFILE_RING_SIZE - 1)].store(((uint64_t)profileMilliseconds() << 32) | ns, std::memory_order_relaxed);
+    ring.total.fetch_add(nanoseconds, std::memory_order_relaxed);
+    ring.head.store(slot + 1, std::memory_order_release);
+}
+
+void profileRecord(ProfileSection section, std::chrono::steady_clock::duration time) {
+    profileRecord(section, std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+struct ProfileScope {
+    ProfileSection section;
+    std::chrono::steady_clock::time_point start;
+
+    bool active;
+
+    explicit ProfileScope(ProfileSection section, bool active = true)
+        : section(section), start(std::chrono::steady_clock::now()), active(active) {}
+    ~ProfileScope() {
+        if (!active) return;
+        profileRecord(section, std::chrono::steady_clock::now() - start);
+    }
+};
+
+// Newest sample of a section in milliseconds (0 before the first one)
+float profileLatest(ProfileSection section) {
+    const ProfileRing& ring = profileRings[section];
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    if (head == 0) return 0;
+    return (uint32_t)ring.samples[(head - 1) & (PROFILE_RING_SIZE - 1)].load(std::memory_order_relaxed) / 1e6f;
+}
+
+struct ProfileStats {
+    float p50 = 0, p99 = 0; // Milliseconds
+    int samples = 0;
+};
+
+// Percentiles of the samples recorded in the last PROFILE_WINDOW_MS
+ProfileStats profileStats(ProfileSection section) {
+    static uint32_t values[PROFILE_RING_SIZE];
+    const ProfileRing& ring = profileRings[section];
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    uint32_t now = profileMilliseconds();
+
+    int count = 0;
+    for (uint32_t i = 0; i < PROFILE_RING_SIZE && i < head; i++) {
+        uint64_t sample = ring.samples[(head - 1 - i) & (PROFILE_RING_SIZE - 1)].load(std::memory_order_relaxed);
+        if (now - (uint32_t)(sample >> 32) > PROFILE_WINDOW_MS) break;
+        values[count++] = (uint32_t)sample;
+    }
+
+    ProfileStats stats;
+    stats.samples = count;
+    if (count > 0) {
+        std::nth_element(values, values + count / 2, values + count);
+        stats.p50 = values[count / 2] / 1e6f;
+        std::nth_element(values, values + count * 99 / 100, values + count);
+        stats.p99 = values[count * 99 / 100] / 1e6f;
+    }
+    return stats;
+}
+
+// GPU frame timing: a few queries in flight, read back only once available (Never stalls)
+const int GPU_QUERY_COUNT = 4;
+GLuint gpuQueries[GPU_QUERY_COUNT];
+bool gpuQueryPending[GPU_QUERY_COUNT] = { false };
+bool gpuQueryActive = false;
+int gpuQueryFrame = 0;
+
+void gpuTimerBegin() {
+    if (!glext.timerQuery) return;
+    if (gpuQueryFrame == 0 && !gpuQueryPending[0]) glext.genQueries(GPU_QUERY_COUNT, gpuQueries);
+
+    int slot = gpuQueryFrame % GPU_QUERY_COUNT;
+    if (gpuQueryPending[slot]) {
+        GLint available = 0;
+        glext.getQueryObjectiv(gpuQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return; // Skip timing this frame rather than wait
+        uint64_t nanoseconds = 0;
+        glext.getQueryObjectui64v(gpuQueries[slot], GL_QUERY_RESULT, &nanoseconds);
+        profileRecord(PROFILE_GPU, nanoseconds);
+    }
+    glext.beginQuery(GL_TIME_ELAPSED, gpuQueries[slot]);
+    gpuQueryPending[slot] = true;
+    gpuQueryActive = true;
+}
+
+void gpuTimerEnd() {
+    if (!gpuQueryActive) return;
+    glext.endQuery(GL_TIME_ELAPSED);
+    gpuQueryActive = false;
+    gpuQueryFrame++;
+}
+
+// === FRAME PACING ===
+// How frames are paced against the display. vsync waits for every refresh (Swap interval 1),
+// adaptive vsync tears instead of waiting a whole extra refresh when a frame is late
+// (Interval -1, needs *_swap_control_tear), uncapped never waits (Interval 0) and calls
+// glFinish after each swap so the driver cannot queue frames ahead of the input.
+// Without a swap-control extension the vsync modes fall back to a sleep-based cap.
+// Frame times and input-to-swap latency are kept in histograms (F3, --frame-stats=FILE).
+enum PacingMode { PACE_VSYNC, PACE_ADAPTIVE, PACE_UNCAPPED, PACE_MODE_COUNT };
+const char* pacingModeNames[PACE_MODE_COUNT] = { "vsync", "adaptive", "uncapped" };
+
+const int HISTOGRAM_BUCKETS = 200;       // The last one also collects everything slower
+const float HISTOGRAM_BUCKET_MS = 0.25f;
+
+struct FrameHistogram {
+    uint32_t buckets[HISTOGRAM_BUCKETS] = { 0 };
+    uint32_t samples = 0;
+};
+
+struct FramePacer {
+    PacingMode mode = PACE_VSYNC;       // --pacing=vsync|adaptive|uncapped, F6 at runtime
+    bool swapControl = false;           // A swap interval entry point was found
+    bool tearControl = false;           // ... and it accepts negative intervals
+    bool intervalSet = false;           // The mode's interval is in effect
+    int interval = 1;
+    int fpsCap = 0;                     // --fps=N (0 = none, 60 when vsync could not be set)
+    std::chrono::steady_clock::time_point nextFrame; // Sleep-based cap
+    std::chrono::steady_clock::time_point lastSwap;  // When glutSwapBuffers last returned
+    std::chrono::steady_clock::time_point lastInput; // Newest input already measured
+    FrameHistogram frames, latency;     // Since the last mode change
+} pacer;
+
+// Swap-control entry points (WGL_EXT_swap_control, or GLX EXT/MESA/SGI_swap_control)
+struct SwapControl {
+#ifdef _WIN32
+    int (APIENTRY* wglSwapInterval)(int interval) = NULL;
+    const char* (APIENTRY* wglExtensions)() = NULL;
+#else
+    void (*glxSwapInterval)(void* display, unsigned long drawable, int interval) = NULL;
+    void* (*glxCurrentDisplay)() = NULL;
+    unsigned long (*glxCurrentDrawable)() = NULL;
+    const char* (*glxExtensions)(void* display, int screen) = NULL;
+    int (*mesaSwapInterval)(unsigned int interval) = NULL;
+    int (*sgiSwapInterval)(int interval) = NULL;
+#endif
+} swapControl;
+
+// Needs the window's context (Called from init)
+void loadSwapControl() {
+    SwapControl& sc = swapControl;
+#ifdef _WIN32
+    if (loadGLProc(sc.wglSwapInterval, "wglSwapIntervalEXT")) {
+        pacer.swapControl = true;
+        pacer.tearControl = loadGLProc(sc.wglExtensions, "wglGetExtensionsStringEXT")
+            && hasExtension(sc.wglExtensions(), "WGL_EXT_swap_control_tear");
+    }
+#else
+    // GLX returns a pointer for any glX name, supported or not: only advertised extensions count
+    const char* extensions = NULL;
+    if (loadGLProc(sc.glxCurrentDisplay, "glXGetCurrentDisplay") && sc.glxCurrentDisplay()
+        && loadGLProc(sc.glxExtensions, "glXQueryExtensionsString")) {
+        extensions = sc.glxExtensions(sc.glxCurrentDisplay(), 0);
+    }
+    if (hasExtension(extensions, "GLX_EXT_swap_control")
+        && loadGLProc(sc.glxSwapInterval, "glXSwapIntervalEXT")
+        && loadGLProc(sc.glxCurrentDrawable, "glXGetCurrentDrawable")) {
+        pacer.swapControl = true;
+        pacer.tearControl = hasExtension(extensions, "GLX_EXT_swap_control_tear");
+    }
+    else {
+        sc.glxSwapInterval = NULL;
+        pacer.swapControl = (hasExtension(extensions, "GLX_MESA_swap_control") && loadGLProc(sc.mesaSwapInterval, "glXSwapIntervalMESA"))
+            || (hasExtension(extensions, "GLX_SGI_swap_control") && loadGLProc(sc.sgiSwapInterval, "glXSwapIntervalSGI"));
+    }
+#endif
+}
+
+bool setSwapInterval(int interval) {
+    SwapControl& sc = swapControl;
+#ifdef _WIN32
+    return sc.wglSwapInterval && sc.wglSwapInterval(interval);
+#else
+    if (sc.glxSwapInterval) {
+        sc.glxSwapInterval(sc.glxCurrentDisplay(), sc.glxCurrentDrawable(), interval);
+        return true;
+    }
+    if (sc.mesaSwapInterval) return interval >= 0 && sc.mesaSwapInterval(interval) == 0;
+    if (sc.sgiSwapInterval) return interval > 0 && sc.sgiSwapInterval(interval) == 0; // SGI cannot turn vsync off
+    return false;
+#endif
+}
+
+// Apply the current mode (Startup and F6). Histograms restart so they describe one mode.
+void applyPacing() {
+    pacer.interval = pacer.mode == PACE_UNCAPPED ? 0 : pacer.mode == PACE_ADAPTIVE && pacer.tearControl ? -1 : 1;
+    pacer.intervalSet = setSwapInterval(pacer.interval);
+    pacer.frames = FrameHistogram();
+    pacer.latency = FrameHistogram();
+    pacer.lastSwap = std::chrono::steady_clock::time_point();
+    pacer.nextFrame = std::chrono::steady_clock::now();
+}
+
+int pacingFpsCap() {
+    if (pacer.fpsCap > 0) return pacer.fpsCap;
+    if (pacer.mode != PACE_UNCAPPED && !pacer.intervalSet) return 60;
+    return 0;
+}
+
+// Idle callback, before asking for the next frame: sleep if a frame cap applies
+void pacingWait() {
+    int fps = pacingFpsCap();
+    if (fps <= 0) return;
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    auto now = std::chrono::steady_clock::now();
+    if (pacer.nextFrame > now) std::this_thread::sleep_until(pacer.nextFrame);
+    pacer.nextFrame += period;
+    if (pacer.nextFrame < now) pacer.nextFrame = now + period; // Fell behind: don't sprint to catch up
+}
+
+void histogramAdd(FrameHistogram& histogram, std::chrono::steady_clock::duration time) {
+    double ms = std::chrono::duration<double, std::milli>(time).count();
+    int bucket = std::min(HISTOGRAM_BUCKETS - 1, std::max(0, (int)(ms / HISTOGRAM_BUCKET_MS)));
+    histogram.buckets[bucket]++;
+    histogram.samples++;
+}
+
+// Milliseconds below which the given fraction of the samples lies (Bucket centre)
+float histogramPercentile(const FrameHistogram& histogram, float fraction) {
+    uint32_t target = (uint32_t)(histogram.samples * fraction);
+    uint32_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram.buckets[i];
+        if (seen > target) return (i + 0.5f) * HISTOGRAM_BUCKET_MS;
+    }
+    return 0;
+}
+
+// Right after glutSwapBuffers: record the frame time and, once per input event, the time
+// from its keyboard callback to the swap of the first frame that shows it
+void pacingAfterSwap(std::chrono::steady_clock::time_point inputTime) {
+    if (pacer.mode == PACE_UNCAPPED) glFinish();
+    auto now = std::chrono::steady_clock::now();
+    if (pacer.lastSwap != std::chrono::steady_clock::time_point()) histogramAdd(pacer.frames, now - pacer.lastSwap);
+    pacer.lastSwap = now;
+    if (inputTime > pacer.lastInput) {
+        histogramAdd(pacer.latency, now - inputTime);
+        pacer.lastInput = inputTime;
+    }
+}
+
+// --frame-stats=FILE: both histograms as CSV when the game exits
+const char* frameStatsPath = NULL;
+
+void writeFrameStats() {
+    FILE* file = fopen(frameStatsPath, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write frame stats to %s\n", frameStatsPath);
+        return;
+    }
+    fprintf(file, "# pacing %s, interval %d%s\n", pacingModeNames[pacer.mode], pacer.interval, pacer.intervalSet ? "" : " (not set)");
+    fprintf(file, "ms,frames,latency\n");
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        fprintf(file, "%.2f,%u,%u\n", i * HISTOGRAM_BUCKET_MS, pacer.frames.buckets[i], pacer.latency.buckets[i]);
+    }
+    fclose(file);
+}
+
+// === VIEWPORT & RENDER SCALE ===
+// The playfield keeps its aspect ratio in any window: reshape() fits the largest
+// centred viewport (The bars either side stay the clear colour) and maps it to
+// playfield units, so layout and game logic never see the window size.
+// --render-scale=S (Below 1) draws the scene into a texture of S times the viewport's
+// pixels and stretches it over the viewport at the end of the frame: a 4K window or a
+// weak GPU pays for fewer fragments, the game itself runs exactly as before.
+struct RenderTarget {
+    float scale = 1.0f;          // --render-scale (0.25-1)
+    int windowWidth = 0, windowHeight = 0;
+    int viewX = 0, viewY = 0, viewWidth = 0, viewHeight = 0; // Letterboxed viewport in the window
+    int x = 0, y = 0, width = 0, height = 0; // Where the scene is drawn this frame (Window or texture)
+    GLuint framebuffer = 0;
+    GLuint texture = 0;
+    int textureWidth = 0, textureHeight = 0;
+    bool offscreen = false;      // This frame goes through the texture
+    bool forced = false;         // Through the texture even at scale 1 (Perf suite renders offscreen)
+    bool failed = false;         // No usable framebuffer objects: full resolution only
+} renderTarget;
+
+// Pixels per playfield unit of the scene being drawn (Point sizes and line widths follow it)
+float pixelsPerUnit() {
+    return renderTarget.height > 0 ? (float)renderTarget.height / playfield.height : 1.0f;
+}
+
+// Largest viewport with the playfield's aspect ratio, centred in the window
+void renderTargetResize(int windowWidth, int windowHeight) {
+    RenderTarget& target = renderTarget;
+    target.windowWidth = std::max(1, windowWidth);
+    target.windowHeight = std::max(1, windowHeight);
+    float fit = std::min((float)target.windowWidth / playfield.width, (float)target.windowHeight / playfield.height);
+    target.viewWidth = std::max(1, (int)(playfield.width * fit + 0.5f));
+    target.viewHeight = std::max(1, (int)(playfield.height * fit + 0.5f));
+    target.viewX = (target.windowWidth - target.viewWidth) / 2;
+    target.viewY = (target.windowHeight - target.viewHeight) / 2;
+}
+
+// Size the offscreen texture for the current viewport (Reallocated only when that changes)
+bool renderTargetAllocate(int width, int height) {
+    if (renderTarget.failed || !glext.framebuffers || glext.major < 2) { // NPOT textures need GL 2.0
+        renderTarget.failed = true;
+        return false;
+    }
+    if (width == renderTarget.textureWidth && height == renderTarget.textureHeight) return true;
+
+    if (!renderTarget.framebuffer) {
+        glext.genFramebuffers(1, &renderTarget.framebuffer);
+        glGenTextures(1, &renderTarget.texture);
+    }
+    glBindTexture(GL_TEXTURE_2D, renderTarget.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glext.bindFramebuffer(GL_FRAMEBUFFER, renderTarget.framebuffer);
+    glext.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, renderTarget.texture, 0);
+    bool complete = glext.checkFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glext.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        fprintf(stderr, "Offscreen render target is incomplete, drawing at full resolution\n");
+        renderTarget.failed = true;
+        return false;
+    }
+    renderTarget.textureWidth = width;
+    renderTarget.textureHeight = height;
+    return true;
+}
+
+// Start of a frame: pick the surface the scene is drawn into and its viewport
+void renderTargetBegin() {
+    RenderTarget& target = renderTarget;
+    int width = std::max(1, (int)(target.viewWidth * target.scale + 0.5f));
+    int height = std::max(1, (int)(target.viewHeight * target.scale + 0.5f));
+    target.offscreen = (target.scale < 1.0f || target.forced) && renderTargetAllocate(width, height);
+    if (target.offscreen) {
+        glext.bindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        target.x = target.y = 0;
+        target.width = width;
+        target.height = height;
+    }
+    else {
+        target.x = target.viewX;
+        target.y = target.viewY;
+        target.width = target.viewWidth;
+        target.height = target.viewHeight;
+    }
+    glViewport(target.x, target.y, target.width, target.height);
+    glPointSize(pixelsPerUnit());
+    glLineWidth(pixelsPerUnit());
+}
+
+// End of a frame: stretch the offscreen scene over the window's viewport
+void renderTargetEnd() {
+    RenderTarget& target = renderTarget;
+    if (!target.offscreen) return;
+
+    glext.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(target.viewX, target.viewY, target.viewWidth, target.viewHeight);
+    glClear(GL_COLOR_BUFFER_BIT); // The letterbox bars
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(0, 0);
+    glTexCoord2f(1, 0); glVertex2f(playfield.width, 0);
+    glTexCoord2f(1, 1); glVertex2f(playfield.width, playfield.height);
+    glTexCoord2f(0, 1); glVertex2f(0, playfield.height);
+    glEnd();
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
+
+// Initialize game
+void init() {
+    glClearColor(0.0, 0.0, 0.1, 1.0);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    // Set 2D coordinates: (0, 0) is bottom-left
+    gluOrtho2D(0, playfield.width, 0, playfield.height);
+    glMatrixMode(GL_MODELVIEW);
+
+    MemoryTagScope tag(MEMORY_RENDER);
+    loadGLExtensions();
+    buildRasterShaders();
+    buildInstancedRenderer();
+    buildParticleRenderer();
+    buildStarfield();
+    loadSwapControl();
+    applyPacing();
+    renderTargetResize(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+
+    // Initialize player and game variables
+    MemoryTagScope entities(MEMORY_ENTITIES);
+    world.reset(time(NULL));
+}
+
+// === GPU RASTER ===
+// Shader version of the DDA, Bresenham and midpoint algorithms. Each line or circle
+// is one instance: the vertex shader expands it to a quad over its bounding box and
+// the fragment shader runs the algorithm for the lattice point under the pixel, keeping
+// exactly the points the CPU version would plot. A primitive costs one 56-byte instance
+// instead of one vertex per plotted point. The CPU versions stay as the reference
+// (--raster=cpu, or F4 at runtime) and are used when the driver lacks GL 3 shaders/instancing.
+enum RasterMode { RASTER_CPU, RASTER_GPU };
+RasterMode rasterMode = RASTER_GPU;
+
+enum RasterKind { RASTER_DDA, RASTER_BRESENHAM, RASTER_MIDPOINT };
+
+struct RasterInstance {
+    GLfloat shape[4];      // Lines: x1, y1, x2, y2; circles: cx, cy, r, 0
+    GLfloat kindColor[4];  // RasterKind, r, g, b
+    GLfloat basis[4];      // Model transform m00, m01, m10, m11
+    GLfloat origin[2];     // Model translation
+};
+
+struct GpuRaster {
+    bool ready = false;     // Program built and buffers created
+    GLuint program = 0;
+    GLint viewportUniform = -1;
+    GLint pixelSizeUniform = -1;
+    GLuint cornerBuffer = 0;
+    GLuint instanceBuffer = 0;
+    ArenaArray<RasterInstance> instances = { &frameArena };
+} gpuRaster;
+
+// Per-frame vertex traffic of the rasterized primitives (Shown in the F3 overlay)
+struct RasterStats {
+    int primitives = 0;
+    size_t bytes = 0;
+} rasterFrame, rasterLastFrame;
+
+enum RasterAttribute { ATTRIB_CORNER, ATTRIB_SHAPE, ATTRIB_KIND_COLOR, ATTRIB_BASIS, ATTRIB_ORIGIN, ATTRIB_COUNT };
+
+const char* rasterVertexShader =
+    "#version 130\n"
+    "in vec2 corner;\n"
+    "in vec4 shape;\n"
+    "in vec4 kindColor;\n"
+    "in vec4 basis;\n"
+    "in vec2 origin;\n"
+    "out vec2 local;\n"
+    "flat out vec4 primitive;\n"
+    "flat out vec4 tint;\n"
+    "flat out vec4 model;\n"
+    "flat out vec2 offset;\n"
+    "void main() {\n"
+    "    vec2 low, high;\n"
+    "    if (kindColor.x < 1.5) {\n"
+    "        low = min(shape.xy, shape.zw);\n"
+    "        high = max(shape.xy, shape.zw);\n"
+    "    } else {\n"
+    "        low = shape.xy - shape.z;\n"
+    "        high = shape.xy + shape.z;\n"
+    "    }\n"
+    "    local = mix(low - 1.0, high + 1.0, corner);\n"
+    "    vec2 world = origin + vec2(dot(basis.xy, local), dot(basis.zw, local));\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(world, 0.0, 1.0);\n"
+    "    primitive = shape;\n"
+    "    tint = kindColor;\n"
+    "    model = basis;\n"
+    "    offset = origin;\n"
+    "}\n";
+
+// Same rounding (Half away from zero) and the same float/integer steps as the CPU code
+const char* rasterFragmentShader =
+    "#version 130\n"
+    "in vec2 local;\n"
+    "flat in vec4 primitive;\n"
+    "flat in vec4 tint;\n"
+    "flat in vec4 model;\n"
+    "flat in vec2 offset;\n"
+    "uniform vec4 viewport;\n"
+    "uniform float pixelSize;\n" // Pixels per playfield unit
+    "float roundAway(float v) { return sign(v) * floor(abs(v) + 0.5); }\n"
+    // Window position of a model-space point, transformed like the CPU path's vertices (The bias
+    // keeps points on exact pixel edges, e.g. integer positions, in the pixel the CPU path lights)
+    "vec2 windowPosition(vec2 p) {\n"
+    "    vec2 world = offset + vec2(model.x * p.x + model.y * p.y, model.z * p.x + model.w * p.y);\n"
+    "    vec4 clip = gl_ModelViewProjectionMatrix * vec4(world, 0.0, 1.0);\n"
+    "    return viewport.xy + (clip.xy / clip.w * 0.5 + 0.5) * viewport.zw + 1.0 / 1024.0;\n"
+    "}\n"
+    "bool ddaPlots(vec2 q) {\n"
+    "    vec2 p = primitive.xy;\n"
+    "    vec2 d = primitive.zw - p;\n"
+    "    float steps = max(abs(d.x), abs(d.y));\n"
+    "    vec2 inc = d / steps;\n"
+    "    for (int i = 0; float(i) <= steps && i < 4096; i++) {\n"
+    "        if (roundAway(p.x) == q.x && roundAway(p.y) == q.y) return true;\n"
+    "        p += inc;\n"
+    "    }\n"
+    "    return false;\n"
+    "}\n"
+    "bool bresenhamPlots(ivec2 q) {\n"
+    "    ivec2 p = ivec2(primitive.xy);\n"
+    "    ivec2 end = ivec2(primitive.zw);\n"
+    "    int dx = abs(end.x - p.x);\n"
+    "    int dy = abs(end.y - p.y);\n"
+    "    int sx = p.x < end.x ? 1 : -1;\n"
+    "    int sy = p.y < end.y ? 1 : -1;\n"
+    "    int err = dx - dy;\n"
+    "    for (int i = 0; i < 8192; i++) {\n"
+    "        if (p == q) return true;\n"
+    "        if (p == end) break;\n"
+    "        int e2 = 2 * err;\n"
+    "        if (e2 > -dy) { err -= dy; p.x += sx; }\n"
+    "        if (e2 < dx) { err += dx; p.y += sy; }\n"
+    "    }\n"
+    "    return false;\n"
+    "}\n"
+    // The midpoint loop keeps y while x^2 + y(y - 1) < r^2, so an octant
+    // point (a, b), a <= b, is plotted exactly when b is the largest such y.
+    "bool midpointPlots(vec2 q) {\n"
+    "    float r = float(int(primitive.z));\n"
+    "    float a = min(abs(q.x), abs(q.y));\n"
+    "    float b = max(abs(q.x), abs(q.y));\n"
+    "    if (r < 1.0) return b == 0.0;\n"
+    "    return a * a + b * (b - 1.0) < r * r && r * r <= a * a + b * (b + 1.0);\n"
+    "}\n"
+    "bool plots(vec2 q) {\n"
+    "    if (tint.x < 0.5) return ddaPlots(q);\n"
+    "    if (tint.x < 1.5) return bresenhamPlots(ivec2(q));\n"
+    "    return midpointPlots(q);\n"
+    "}\n"
+    // A size 1 point lights the pixel its window position falls in. Under rotation that is not
+    // always the nearest lattice point, so the 3x3 lattice points around this pixel are tried.
+    // Upscaled, a point covers a block of pixels (Like the CPU path's glPointSize) and every
+    // pixel belongs to the lattice point nearest to it.
+    "void main() {\n"
+    "    vec2 centre = tint.x < 1.5 ? vec2(0.0) : primitive.xy;\n"
+    "    vec2 nearest = floor(local - centre + 0.5);\n"
+    "    if (pixelSize >= 1.5) {\n"
+    "        if (!plots(nearest)) discard;\n"
+    "        gl_FragColor = vec4(tint.yzw, 1.0);\n"
+    "        return;\n"
+    "    }\n"
+    "    for (int k = 0; k < 9; k++) {\n"
+    "        vec2 q = nearest + vec2(float(k - k / 3 * 3) - 1.0, float(k / 3) - 1.0);\n"
+    "        if (floor(windowPosition(centre + q)) != floor(gl_FragCoord.xy)) continue;\n"
+    "        if (plots(q)) {\n"
+    "            gl_FragColor = vec4(tint.yzw, 1.0);\n"
+    "            return;\n"
+    "        }\n"
+    "    }\n"
+    "    discard;\n"
+    "}\n";
+
+// Compile one GLSL stage (Returns 0 and prints the log on failure; callers fall back)
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glext.createShader(type);
+    glext.shaderSource(shader, 1, &source, NULL);
+    glext.compileShader(shader);
+    GLint compiled = 0;
+    glext.getShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[1024] = "";
+        glext.getShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader did not compile, using the fixed-function path:\n%s\n", log);
+        return 0;
+    }
+    return shader;
+}
+
+bool linkProgram(GLuint program) {
+    glext.linkProgram(program);
+    GLint linked = 0;
+    glext.getProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024] = "";
+        glext.getProgramInfoLog(program, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader did not link, using the fixed-function path:\n%s\n", log);
+    }
+    return linked != 0;
+}
+
+// Needs a current GL context (Called from init, after loadGLExtensions)
+void buildRasterShaders() {
+    if (!glext.shaders || !glext.instancing || !glext.vertexBuffers) return;
+
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, rasterVertexShader);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, rasterFragmentShader);
+    if (!vertex || !fragment) return;
+
+    GLuint program = glext.createProgram();
+    glext.attachShader(program, vertex);
+    glext.attachShader(program, fragment);
+    glext.bindAttribLocation(program, ATTRIB_CORNER, "corner");
+    glext.bindAttribLocation(program, ATTRIB_SHAPE, "shape");
+    glext.bindAttribLocation(program, ATTRIB_KIND_COLOR, "kindColor");
+    glext.bindAttribLocation(program, ATTRIB_BASIS, "basis");
+    glext.bindAttribLocation(program, ATTRIB_ORIGIN, "origin");
+    if (!linkProgram(program)) return;
+
+    // Unit quad as a triangle strip (Scaled to each primitive's box in the vertex shader)
+    static const GLfloat corners[] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+    glext.genBuffers(1, &gpuRaster.cornerBuffer);
+    glext.bindBuffer(GL_ARRAY_BUFFER, gpuRaster.cornerBuffer);
+    glext.bufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glext.genBuffers(1, &gpuRaster.instanceBuffer);
+    glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    gpuRaster.program = program;
+    gpuRaster.viewportUniform = glext.getUniformLocation(program, "viewport");
+    gpuRaster.pixelSizeUniform = glext.getUniformLocation(program, "pixelSize");
+    gpuRaster.ready = true;
+}
+
+bool rasterOnGpu() {
+    return rasterMode == RASTER_GPU && gpuRaster.ready;
+}
+
+// Queue one primitive in the given model transform (Into the immediate-mode list by default)
+void rasterAdd(RasterKind kind, float a, float b, float c, float d, const float* color,
+    float m00, float m01, float m10, float m11, float tx, float ty, ArenaArray<RasterInstance>& target = gpuRaster.instances) {
+    RasterInstance instance = {
+        { a, b, c, d }, { (float)kind, color[0], color[1], color[2] }, { m00, m01, m10, m11 }, { tx, ty }
+    };
+    target.push_back(instance);
+}
+
+// Queue one primitive in the current GL matrix and colour (Immediate-mode callers)
+void rasterAddImmediate(RasterKind kind, float a, float b, float c, float d) {
+    GLfloat color[4];
+    glGetFloatv(GL_CURRENT_COLOR, color);
+    rasterAdd(kind, a, b, c, d, color, 1, 0, 0, 1, 0, 0);
+}
+
+// Draw every queued primitive with one instanced call, and empty the list
+void rasterFlush(ArenaArray<RasterInstance>& instances = gpuRaster.instances) {
+    size_t count = instances.size();
+    if (count == 0) return;
+    size_t bytes = count * sizeof(RasterInstance);
+    rasterFrame.primitives += (int)count;
+    rasterFrame.bytes += bytes;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glext.useProgram(gpuRaster.program);
+    glext.uniform4f(gpuRaster.viewportUniform, viewport[0], viewport[1], viewport[2], viewport[3]);
+    glext.uniform1f(gpuRaster.pixelSizeUniform, pixelsPerUnit());
+    glext.bindBuffer(GL_ARRAY_BUFFER, gpuRaster.cornerBuffer);
+    glext.vertexAttribPointer(ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+    glext.enableVertexAttribArray(ATTRIB_CORNER);
+
+    // Orphan and refill the instance buffer (The driver keeps the previous one while in use)
+    glext.bindBuffer(GL_ARRAY_BUFFER, gpuRaster.instanceBuffer);
+    glext.bufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+    glext.bufferData(GL_ARRAY_BUFFER, bytes, instances.data(), GL_STREAM_DRAW);
+    const struct { GLuint index; GLint size; size_t offset; } attributes[] = {
+        { ATTRIB_SHAPE, 4, offsetof(RasterInstance, shape) },
+        { ATTRIB_KIND_COLOR, 4, offsetof(RasterInstance, kindColor) },
+        { ATTRIB_BASIS, 4, offsetof(RasterInstance, basis) },
+        { ATTRIB_ORIGIN, 2, offsetof(RasterInstance, origin) },
+    };
+    for (const auto& attribute : attributes) {
+        glext.vertexAttribPointer(attribute.index, attribute.size, GL_FLOAT, GL_FALSE,
+            sizeof(RasterInstance), (const void*)attribute.offset);
+        glext.enableVertexAttribArray(attribute.index);
+        glext.vertexAttribDivisor(attribute.index, 1);
+    }
+
+    glext.drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+
+    // Leave the fixed-function state as the rest of the frame expects it
+    for (const auto& attribute : attributes) {
+        glext.vertexAttribDivisor(attribute.index, 0);
+        glext.disableVertexAttribArray(attribute.index);
+    }
+    glext.disableVertexAttribArray(ATTRIB_CORNER);
+    glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glext.useProgram(0);
+    instances.clear();
+}
+
+// Count plotted points sent by the CPU path (Same overlay line as the GPU instances)
+void rasterCountPoints(size_t points, size_t vertexBytes) {
+    rasterFrame.primitives += (int)points;
+    rasterFrame.bytes += points * vertexBytes;
+}
+
+// Start a frame's traffic counters (Keeps the previous frame for the overlay)
+void rasterFrameBegin() {
+    rasterLastFrame = rasterFrame;
+    rasterFrame = RasterStats();
+}
+
+// DDA Line Algorithm (Calls plot(x, y) for every rasterized point)
+template <typename Plot>
+void rasterLineDDA(float x1, float y1, float x2, float y2, Plot plot) {
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float steps = fabs(dx) > fabs(dy) ? fabs(dx) : fabs(dy);
+
+    float xInc = dx / steps;
+    float yInc = dy / steps;
+
+    float x = x1, y = y1;
+
+    for (int i = 0; i <= steps; i++) {
+        plot(round(x), round(y));
+        x += xInc;
+        y += yInc;
+    }
+}
+
+// DDA Line Algorithm (Not used for primary drawing, but kept for completeness)
+void drawLineDDA(float x1, float y1, float x2, float y2) {
+    if (rasterOnGpu()) {
+        rasterAddImmediate(RASTER_DDA, x1, y1, x2, y2);
+        return;
+    }
+    glBegin(GL_POINTS);
+    rasterLineDDA(x1, y1, x2, y2, [](float x, float y) { glVertex2f(x, y); });
+    glEnd();
+}
+
+// Bresenham's Line Algorithm (Used for Ship Wings)
+void drawLineBresenham(int x1, int y1, int x2, int y2) {
+    if (rasterOnGpu()) {
+        rasterAddImmediate(RASTER_BRESENHAM, x1, y1, x2, y2);
+        return;
+    }
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+    int sx = (x1 < x2) ? 1 : -1;
+    int sy = (y1 < y2) ? 1 : -1;
+    int err = dx - dy;
+
+    glBegin(GL_POINTS);
+    while (true) {
+        glVertex2i(x1, y1);
+        rasterCountPoints(1, 2 * sizeof(GLint));
+
+        if (x1 == x2 && y1 == y2) break;
+
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x1 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y1 += sy;
+        }
+    }
+    glEnd();
+}
+
+// Midpoint Circle Algorithm (Calls plot(x, y) for every rasterized point)
+template <typename Plot>
+void rasterCircleMidpoint(float cx, float cy, float r, Plot plot) {
+    int x = 0;
+    int y = r;
+    int d = 1 - r;
+
+    auto plotCirclePoints = [&](int x, int y) {
+        plot(cx + x, cy + y);
+        plot(cx - x, cy + y);
+        plot(cx + x, cy - y);
+        plot(cx - x, cy - y);
+        plot(cx + y, cy + x);
+        plot(cx - y, cy + x);
+        plot(cx + y, cy - x);
+        plot(cx - y, cy - x);
+        };
+
+    while (x <= y) {
+        plotCirclePoints(x, y);
+        x++;
+        if (d < 0) {
+            d += 2 * x + 1;
+        }
+        else {
+            y--;
+            d += 2 * (x - y) + 1;
+        }
+    }
+}
+
+// === SHAPE CACHE ===
+// Circle geometry is built once and reused by every draw call.
+// Filled circles use a unit-circle table per segment count, and midpoint
+// outlines keep the rasterized offsets per integer radius.
+struct CirclePoint {
+    float x, y;
+};
+
+const int MAX_CIRCLE_SEGMENTS = 360;
+const int MAX_CACHED_RADIUS = 64;
+
+// Unit-circle tables: segments + 1 points, last one equal to the first
+std::vector<CirclePoint> unitCircleTables[MAX_CIRCLE_SEGMENTS + 1];
+// Midpoint offsets relative to the centre, in the order the algorithm plots them
+std::vector<CirclePoint> midpointTables[MAX_CACHED_RADIUS + 1];
+
+// Adaptive segment count (About one segment per 2 units of circumference)
+int circleSegments(float r) {
+    int segments = (int)ceil(2 * 3.14159f * r / 2);
+    return std::max(12, std::min(MAX_CIRCLE_SEGMENTS, segments));
+}
+
+const std::vector<CirclePoint>& unitCircle(int segments) {
+    std::vector<CirclePoint>& table = unitCircleTables[segments];
+    if (table.empty()) {
+        table.resize(segments + 1);
+        for (int i = 0; i < segments; i++) {
+            double angle = 2 * 3.14159265358979 * i / segments;
+            table[i].x = (float)cos(angle);
+            table[i].y = (float)sin(angle);
+        }
+        table[segments] = table[0];
+    }
+    return table;
+}
+
+// Offsets for one radius (Computed with rasterCircleMidpoint on first use)
+const std::vector<CirclePoint>& midpointCircle(float r) {
+    int radius = (int)r;
+    if (radius < 0 || radius > MAX_CACHED_RADIUS) {
+        // Too large to keep around, rasterize on every call
+        static std::vector<CirclePoint> uncached;
+        uncached.clear();
+        rasterCircleMidpoint(0, 0, r, [](float x, float y) { uncached.push_back({ x, y }); });
+        return uncached;
+    }
+
+    std::vector<CirclePoint>& table = midpointTables[radius];
+    if (table.empty()) {
+        rasterCircleMidpoint(0, 0, r, [&](float x, float y) { table.push_back({ x, y }); });
+    }
+    return table;
+}
+
+// Midpoint Circle Algorithm (Used for Ship Cockpit and Enemy Outlines)
+void drawCircleMidpoint(float cx, float cy, float r) {
+    if (rasterOnGpu()) {
+        rasterAddImmediate(RASTER_MIDPOINT, cx, cy, r, 0);
+        return;
+    }
+    const std::vector<CirclePoint>& points = midpointCircle(r);
+    glBegin(GL_POINTS);
+    for (const CirclePoint& p : points) {
+        glVertex2f(cx + p.x, cy + p.y);
+    }
+    glEnd();
+    rasterCountPoints(points.size(), sizeof(CirclePoint));
+}
+
+// Filled circle (Used for Life Icons, Power-ups, and Circular Enemy Body)
+void drawFilledCircle(float cx, float cy, float r) {
+    glBegin(GL_TRIANGLE_FAN);
+    glVertex2f(cx, cy);
+    for (const CirclePoint& p : unitCircle(circleSegments(r))) {
+        glVertex2f(cx + r * p.x, cy + r * p.y);
+    }
+    glEnd();
+}
+
+// === TEXT ===
+// The GLUT bitmap font is rasterized once into a texture atlas (Drawn with
+// glutBitmapCharacter into the back buffer and copied into a texture). A string
+// is laid out into one quad array and kept in a TextLabel until its text changes.
+struct Glyph {
+    float u0, v0, u1, v1; // Cell in the atlas
+    int advance;          // Pen movement in pixels
+};
+
+const int ATLAS_WIDTH = 256;
+const int ATLAS_HEIGHT = 128;
+const int GLYPH_CELL_HEIGHT = 24;
+const int GLYPH_BASELINE = 6; // Pixels below the baseline (Descenders)
+const int GLYPH_PADDING = 2;  // Pixels left/right of the advance (Overhanging glyphs)
+
+struct FontAtlas {
+    GLuint texture = 0;
+    bool ready = false;
+    bool failed = false; // Fall back to glutBitmapCharacter
+    Glyph glyphs[128];
+} font;
+
+// Needs a visible window: called from display() before the frame is cleared
+void buildFontAtlas() {
+    MemoryTagScope tag(MEMORY_TEXT);
+    void* bitmapFont = GLUT_BITMAP_HELVETICA_18;
+    int windowWidth = glutGet(GLUT_WINDOW_WIDTH);
+    int windowHeight = glutGet(GLUT_WINDOW_HEIGHT);
+    if (windowWidth < ATLAS_WIDTH || windowHeight < ATLAS_HEIGHT) {
+        font.failed = true;
+        return;
+    }
+
+    // Draw every printable glyph white on black in a 1:1 pixel projection
+    glViewport(0, 0, windowWidth, windowHeight);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, windowWidth, 0, windowHeight);
+    glMatrixMode(GL_MODELVIEW);
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glColor3f(1.0, 1.0, 1.0);
+
+    int penX = 0, penY = 0;
+    for (int c = 0; c < 128; c++) {
+        font.glyphs[c] = Glyph();
+        if (c < 32 || c > 126) continue;
+
+        int advance = glutBitmapWidth(bitmapFont, c);
+        int cellWidth = advance + 2 * GLYPH_PADDING;
+        if (penX + cellWidth > ATLAS_WIDTH) {
+            penX = 0;
+            penY += GLYPH_CELL_HEIGHT;
+        }
+        if (penY + GLYPH_CELL_HEIGHT > ATLAS_HEIGHT) break;
+
+        glRasterPos2i(penX + GLYPH_PADDING, penY + GLYPH_BASELINE);
+        glutBitmapCharacter(bitmapFont, c);
+
+        Glyph& glyph = font.glyphs[c];
+        glyph.u0 = (float)penX / ATLAS_WIDTH;
+        glyph.v0 = (float)penY / ATLAS_HEIGHT;
+        glyph.u1 = (float)(penX + cellWidth) / ATLAS_WIDTH;
+        glyph.v1 = (float)(penY + GLYPH_CELL_HEIGHT) / ATLAS_HEIGHT;
+        glyph.advance = advance;
+        penX += cellWidth;
+    }
+
+    // Intensity texture: glyph pixels become opaque, everything else is discarded by the alpha test
+    glGenTextures(1, &font.texture);
+    glBindTexture(GL_TEXTURE_2D, font.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_INTENSITY, 0, 0, ATLAS_WIDTH, ATLAS_HEIGHT, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    font.ready = glGetError() == GL_NO_ERROR;
+    font.failed = !font.ready;
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glClearColor(0.0, 0.0, 0.1, 1.0);
+}
+
+// One laid-out string: (x, y, u, v) per quad corner
+struct TextLabel {
+    char text[96] = "";
+    float x = 0, y = 0;
+    bool usesAtlas = false; // Laid out with the atlas (Redone once it becomes ready)
+    GLfloat vertices[sizeof(text) * 16];
+    int vertexCount = 0;    // Floats used in vertices
+};
+
+// Lay out text at (x, y) unless the label already holds exactly that
+void layoutLabel(TextLabel& label, float x, float y, const char* text) {
+    if (label.usesAtlas == font.ready && label.x == x && label.y == y && strcmp(label.text, text) == 0) return;
+
+    MemoryTagScope tag(MEMORY_TEXT);
+    snprintf(label.text, sizeof(label.text), "%s", text);
+    label.x = x;
+    label.y = y;
+    label.usesAtlas = font.ready;
+    label.vertexCount = 0;
+    if (!font.ready) return;
+
+    float pen = x;
+    for (const char* c = label.text; *c != '\0'; c++) {
+        const Glyph& glyph = font.glyphs[*c & 127];
+        float x0 = pen - GLYPH_PADDING, x1 = pen + glyph.advance + GLYPH_PADDING;
+        float y0 = y - GLYPH_BASELINE, y1 = y0 + GLYPH_CELL_HEIGHT;
+        GLfloat quad[16] = {
+            x0, y0, glyph.u0, glyph.v0,
+            x1, y0, glyph.u1, glyph.v0,
+            x1, y1, glyph.u1, glyph.v1,
+            x0, y1, glyph.u0, glyph.v1,
+        };
+        std::copy(quad, quad + 16, label.vertices + label.vertexCount);
+        label.vertexCount += 16;
+        pen += glyph.advance;
+    }
+}
+
+// Draw a laid-out label in the current colour (One draw call per string)
+void drawLabel(const TextLabel& label) {
+    if (!font.ready) {
+        glRasterPos2f(label.x, label.y);
+        for (const char* c = label.text; *c != '\0'; c++) {
+            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
+        }
+        return;
+    }
+    if (label.vertexCount == 0) return;
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, font.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &label.vertices[0]);
+    glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &label.vertices[2]);
+    glDrawArrays(GL_QUADS, 0, label.vertexCount / 4);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisable(GL_ALPHA_TEST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
+
+// Draw text (Used for one-off strings like the profiler, laid out every call)
+void drawText(float x, float y, const char* text) {
+    static TextLabel scratch;
+    layoutLabel(scratch, x, y, text);
+    drawLabel(scratch);
+}
+
+// Label showing one number: only re-formatted and laid out when the value changes
+struct CounterLabel {
+    int value = 0;
+    bool dirty = true;
+    TextLabel label;
+};
+
+void drawCounter(CounterLabel& counter, float x, float y, const char* format, int value) {
+    if (counter.dirty || counter.value != value || counter.label.usesAtlas != font.ready) {
+        char text[64];
+        snprintf(text, sizeof(text), format, value);
+        layoutLabel(counter.label, x, y, text);
+        counter.value = value;
+        counter.dirty = false;
+    }
+    drawLabel(counter.label);
+}
+
+// === STARFIELD ===
+// Star positions never change, only the scroll offset does. Each layer is built
+// once into a vertex buffer (Or a client-side array without VBO support) and
+// scrolled with one translation, drawn twice to cover the wrap-around.
+struct StarLayer {
+    std::vector<GLfloat> points; // x, y pairs with y in [0, playfield.height)
+    GLuint buffer = 0;           // 0 = draw from points directly
+    float speed;                 // Scroll speed relative to starOffset
+    float brightness;
+    float size;
+};
+
+std::vector<StarLayer> starLayers;
+int parallaxLayers = 0;          // Extra background layers (--star-layers=N)
+const int STARS_PER_LAYER = 2000;
+
+void uploadStarLayer(StarLayer& layer) {
+    if (!glext.vertexBuffers) return;
+    glext.genBuffers(1, &layer.buffer);
+    glext.bindBuffer(GL_ARRAY_BUFFER, layer.buffer);
+    glext.bufferData(GL_ARRAY_BUFFER, layer.points.size() * sizeof(GLfloat), layer.points.data(), GL_STATIC_DRAW);
+    glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Build every layer (Called from init, needs the GL extensions)
+void buildStarfield() {
+    starLayers.clear();
+
+    // Parallax layers, farthest first. Layer k scrolls at 1/(k+1) speed, so its
+    // pattern repeats every playfield.height/(k+1) to stay seamless when starOffset wraps:
+    // one tile of stars is generated and copied k + 1 times up the screen.
+    for (int k = parallaxLayers; k >= 1; k--) {
+        StarLayer layer;
+        int repeats = k + 1;
+        float tile = (float)playfield.height / repeats;
+        uint32_t hash = 2166136261u + k;
+        for (int i = 0; i < STARS_PER_LAYER / repeats; i++) {
+            hash = hash * 1664525u + 1013904223u;
+            float x = (float)(hash >> 8) / (1 << 24) * playfield.width;
+            hash = hash * 1664525u + 1013904223u;
+            float y = (float)(hash >> 8) / (1 << 24) * tile;
+            layer.points.push_back(x);
+            layer.points.push_back(y);
+        }
+        size_t tileSize = layer.points.size();
+        for (int copy = 1; copy < repeats; copy++) {
+            for (size_t i = 0; i < tileSize; i += 2) {
+                layer.points.push_back(layer.points[i]);
+                layer.points.push_back(layer.points[i + 1] + copy * tile);
+            }
+        }
+        layer.speed = 1.0f / repeats;
+        layer.brightness = 0.3f + 0.4f / k;
+        layer.size = 1.0;
+        starLayers.push_back(layer);
+    }
+
+    // Main layer (The original 100 stars)
+    StarLayer layer;
+    for (int i = 0; i < 100; i++) {
+        layer.points.push_back((i * 73) % playfield.width);
+        layer.points.push_back((i * 117) % playfield.height);
+    }
+    layer.speed = 1.0;
+    layer.brightness = 1.0;
+    layer.size = 2.0;
+    starLayers.push_back(layer);
+
+    for (StarLayer& star : starLayers) {
+        uploadStarLayer(star);
+    }
+}
+
+// Draw stars (Background scrolling effect)
+void drawStars(float offset) {
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    for (const StarLayer& layer : starLayers) {
+        glColor3f(layer.brightness, layer.brightness, layer.brightness);
+        glPointSize(layer.size * pixelsPerUnit());
+
+        if (layer.buffer) {
+            glext.bindBuffer(GL_ARRAY_BUFFER, layer.buffer);
+            glVertexPointer(2, GL_FLOAT, 0, NULL);
+        }
+        else {
+            glVertexPointer(2, GL_FLOAT, 0, layer.points.data());
+        }
+
+        // Scroll, then draw again one screen lower for the stars that wrapped around
+        float shift = fmod(offset * layer.speed, playfield.height);
+        GLsizei count = (GLsizei)(layer.points.size() / 2);
+        glPushMatrix();
+        glTranslatef(0, shift, 0);
+        glDrawArrays(GL_POINTS, 0, count);
+        glTranslatef(0, -playfield.height, 0);
+        glDrawArrays(GL_POINTS, 0, count);
+        glPopMatrix();
+
+        if (layer.buffer) glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPointSize(pixelsPerUnit());
+}
+
+// Draw player spaceship (Triangle Ship with wobble animation)
+void drawPlayer(const Player& ship, float x, float y) {
+    glPushMatrix();
+
+    // 1. Translation: Move drawing origin to player's center (x, y)
+    glTranslatef(x, y, 0);
+
+    // 2. Rotation effect (wobble)
+    float wobble = sin(glutGet(GLUT_ELAPSED_TIME) * 0.005) * 2;
+    glRotatef(wobble, 0, 0, 1);
+
+    glLineWidth(3.0 * pixelsPerUnit());
+
+    // --- Determine Ship Color (Red Alert on 1 Life) ---
+    if (ship.lives == 1) {
+        glColor3f(1.0, 0.0, 0.0); // CRITICAL: Red
+    }
+    else {
+        glColor3f(0.0, 0.8, 1.0); // Default Blue color
+    }
+
+    // --- Draw Triangle Ship ---
+    glBegin(GL_TRIANGLES);
+    glVertex2f(0, ship.size); // Top point
+    glVertex2f(-ship.size / 2, -ship.size / 2); // Bottom-left
+    glVertex2f(ship.size / 2, -ship.size / 2); // Bottom-right
+    glEnd();
+
+    // Cockpit 
+    glColor3f(0.3, 0.9, 1.0);
+    drawCircleMidpoint(0, ship.size / 3, ship.size / 4);
+    // Extra cockpits for style
+    drawCircleMidpoint(10, ship.size / 3, ship.size / 4);
+    drawCircleMidpoint(-10, ship.size / 3, ship.size / 4);
+    drawCircleMidpoint(0, -ship.size, ship.size / 4);
+
+
+    // Wings (Drawn using Bresenham's algorithm)
+    glColor3f(0.0, 0.6, 0.8);
+    drawLineBresenham(-ship.size / 2, -ship.size / 2, -ship.size, -ship.size);
+    drawLineBresenham(ship.size / 2, -ship.size / 2, ship.size, -ship.size);
+
+    // Shader path: draw the queued cockpits and wings while the ship's matrix is current
+    if (rasterOnGpu()) rasterFlush();
+
+    glLineWidth(pixelsPerUnit());
+
+    glPopMatrix();
+}
+
+// === LEVEL OF DETAIL ===
+// Enemies and power-ups have four representations, each cheaper than the last:
+//   full     filled fan + midpoint outline, DDA point outlines (The reference look)
+//   reduced  8-segment fans, outlines as GL_LINES
+//   solid    one quad per object in its colour
+//   sprite   one large point per object
+// A governor picks the level once per frame from the number of objects on screen and
+// the render cost the profiler measured for the previous frames. Both have hysteresis,
+// so a dense wave steps the detail down within a few frames and it only comes back
+// after the load has stayed low for about two seconds.
+enum DetailLevel { LOD_FULL, LOD_REDUCED, LOD_SOLID, LOD_SPRITE, LOD_LEVEL_COUNT };
+const char* detailLevelNames[LOD_LEVEL_COUNT] = { "full", "reduced", "solid", "sprite" };
+
+// Objects on screen, as a share of the enemy and power-up pools (--pools scales them with it)
+const float LOD_COUNT_SHARES[LOD_LEVEL_COUNT] = { 0, 0.15f, 0.4f, 0.75f };
+const float LOD_COUNT_HYSTERESIS = 0.8f; // Come back up once below 80% of a threshold
+const int LOD_OVER_FRAMES = 10;          // Over budget this many frames in a row: one level down
+const int LOD_UNDER_FRAMES = 120;        // Below LOD_UNDER_SHARE of the budget: one level up
+const float LOD_UNDER_SHARE = 0.5f;
+const int LOD_REDUCED_SEGMENTS = 8;
+const float LOD_SPRITE_SIZE = 12;        // Pixels at 1 pixel per unit
+
+struct LodGovernor {
+    bool automatic = true;           // --lod=LEVEL or F7 pin one level
+    DetailLevel level = LOD_FULL;    // Used for this frame
+    DetailLevel countLevel = LOD_FULL; // From the object count alone
+    int pressure = 0;                // Extra levels down because of the frame budget
+    float budgetMs = 8;              // --lod-budget=MS: render cost to hold (0 = count only)
+    float costMs = 0;                // Smoothed max(CPU render, GPU) of the recent frames
+    int overFrames = 0, underFrames = 0;
+    long long switches = 0;          // Level changes (F3 overlay)
+} lod;
+
+// Once per frame, before the objects are drawn
+DetailLevel lodUpdate(int objects) {
+    LodGovernor& governor = lod;
+    float cost = std::max(profileLatest(PROFILE_RENDER), profileLatest(PROFILE_GPU));
+    governor.costMs += (cost - governor.costMs) * 0.25f;
+
+    float capacity = (float)(poolConfig.enemies + poolConfig.powerUps);
+    auto threshold = [&](int level) { return LOD_COUNT_SHARES[level] * capacity; };
+    int countLevel = governor.countLevel;
+    while (countLevel + 1 < LOD_LEVEL_COUNT && objects >= threshold(countLevel + 1)) countLevel++;
+    while (countLevel > 0 && objects < threshold(countLevel) * LOD_COUNT_HYSTERESIS) countLevel--;
+    governor.countLevel = (DetailLevel)countLevel;
+
+    if (governor.budgetMs > 0) {
+        bool over = governor.costMs > governor.budgetMs;
+        bool under = governor.costMs < governor.budgetMs * LOD_UNDER_SHARE;
+        governor.overFrames = over ? governor.overFrames + 1 : 0;
+        governor.underFrames = under ? governor.underFrames + 1 : 0;
+        if (governor.overFrames >= LOD_OVER_FRAMES && countLevel + governor.pressure < LOD_SPRITE) {
+            governor.pressure++;
+            governor.overFrames = 0;
+        }
+        if (governor.underFrames >= LOD_UNDER_FRAMES && governor.pressure > 0) {
+            governor.pressure--;
+            governor.underFrames = 0;
+        }
+    }
+
+    DetailLevel level = governor.level;
+    if (governor.automatic) level = (DetailLevel)std::min<int>(LOD_SPRITE, countLevel + governor.pressure);
+    if (level != governor.level) governor.switches++;
+    governor.level = level;
+    return level;
+}
+
+// === BATCHED RENDERING ===
+// Bullets, enemies and power-ups are not drawn with their own glBegin/glEnd.
+// Their vertices are transformed on the CPU and collected into one client-side
+// vertex array per primitive type and layer, which is submitted once per frame.
+// Layers are flushed in drawing order, so power-ups still cover enemies and
+// enemies cover bullets (Within a layer, fills go first and outlines on top).
+struct BatchVertex {
+    GLfloat x, y;
+    GLfloat r, g, b;
+};
+
+struct PrimitiveBatch {
+    GLenum mode;
+    ArenaArray<BatchVertex> vertices = { &frameArena };
+
+    PrimitiveBatch(GLenum mode) : mode(mode) {}
+};
+
+enum BatchLayerId { LAYER_BULLETS, LAYER_ENEMIES, LAYER_POWERUPS, BATCH_LAYER_COUNT };
+
+struct BatchLayer {
+    PrimitiveBatch triangles = { GL_TRIANGLES };
+    PrimitiveBatch lines = { GL_LINES };
+    PrimitiveBatch points = { GL_POINTS };
+    PrimitiveBatch sprites = { GL_POINTS }; // LOD_SPRITE stand-ins (Drawn with a larger point size)
+    ArenaArray<RasterInstance> raster = { &frameArena }; // Shader-rasterized outlines (GPU path)
+};
+
+struct BatchRenderer {
+    BatchLayer layers[BATCH_LAYER_COUNT];
+    BatchLayer* layer = &layers[LAYER_BULLETS]; // Receives the vertices (See batchLayer)
+
+    // Current model transform (CPU version of glTranslatef/glRotatef/glScalef)
+    float tx = 0, ty = 0;
+    float m00 = 1, m01 = 0, m10 = 0, m11 = 1;
+
+    // Current colour (CPU version of glColor3f)
+    float r = 1, g = 1, b = 1;
+} batch;
+
+// Start a new batch of geometry (Storage comes from the frame arena)
+void batchBegin() {
+    for (BatchLayer& layer : batch.layers) {
+        layer.triangles.vertices.clear();
+        layer.lines.vertices.clear();
+        layer.points.vertices.clear();
+        layer.sprites.vertices.clear();
+        layer.raster.clear();
+    }
+    batch.layer = &batch.layers[LAYER_BULLETS];
+}
+
+// Collect the following geometry into one layer
+void batchLayer(BatchLayerId id) {
+    batch.layer = &batch.layers[id];
+}
+
+// Set the model transform: translate to (x, y), rotate by degrees, then scale
+void batchTransform(float x, float y, float degrees, float scale) {
+    float angle = fmod(degrees, 360.0f) * 3.14159f / 180;
+    float c = cos(angle) * scale;
+    float s = sin(angle) * scale;
+    batch.tx = x;
+    batch.ty = y;
+    batch.m00 = c; batch.m01 = -s;
+    batch.m10 = s; batch.m11 = c;
+}
+
+void batchColor(float r, float g, float b) {
+    batch.r = r;
+    batch.g = g;
+    batch.b = b;
+}
+
+// Add one vertex in model space (Transformed to world space on the CPU)
+void batchVertex(PrimitiveBatch& target, float x, float y) {
+    BatchVertex v;
+    v.x = batch.tx + batch.m00 * x + batch.m01 * y;
+    v.y = batch.ty + batch.m10 * x + batch.m11 * y;
+    v.r = batch.r;
+    v.g = batch.g;
+    v.b = batch.b;
+    target.vertices.push_back(v);
+}
+
+// Quad as two triangles (Same split GL uses for convex GL_QUADS)
+void batchQuad(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3) {
+    batchVertex(batch.layer->triangles, x0, y0);
+    batchVertex(batch.layer->triangles, x1, y1);
+    batchVertex(batch.layer->triangles, x2, y2);
+    batchVertex(batch.layer->triangles, x0, y0);
+    batchVertex(batch.layer->triangles, x2, y2);
+    batchVertex(batch.layer->triangles, x3, y3);
+}
+
+// Batched version of drawFilledCircle (Fan unrolled into triangles)
+void batchFilledCircle(float cx, float cy, float r) {
+    const std::vector<CirclePoint>& circle = unitCircle(circleSegments(r));
+    for (size_t i = 1; i < circle.size(); i++) {
+        batchVertex(batch.layer->triangles, cx, cy);
+        batchVertex(batch.layer->triangles, cx + r * circle[i - 1].x, cy + r * circle[i - 1].y);
+        batchVertex(batch.layer->triangles, cx + r * circle[i].x, cy + r * circle[i].y);
+    }
+}
+
+// Batched version of drawCircleMidpoint
+void batchCircleMidpoint(float cx, float cy, float r) {
+    if (rasterOnGpu()) {
+        const float color[3] = { batch.r, batch.g, batch.b };
+        rasterAdd(RASTER_MIDPOINT, cx, cy, r, 0, color, batch.m00, batch.m01, batch.m10, batch.m11, batch.tx, batch.ty,
+            batch.layer->raster);
+        return;
+    }
+    for (const CirclePoint& p : midpointCircle(r)) {
+        batchVertex(batch.layer->points, cx + p.x, cy + p.y);
+    }
+}
+
+// Batched version of drawLineDDA
+void batchLineDDA(float x1, float y1, float x2, float y2) {
+    if (rasterOnGpu()) {
+        const float color[3] = { batch.r, batch.g, batch.b };
+        rasterAdd(RASTER_DDA, x1, y1, x2, y2, color, batch.m00, batch.m01, batch.m10, batch.m11, batch.tx, batch.ty,
+            batch.layer->raster);
+        return;
+    }
+    rasterLineDDA(x1, y1, x2, y2, [](float x, float y) { batchVertex(batch.layer->points, x, y); });
+}
+
+void flushBatch(const PrimitiveBatch& primitives) {
+    if (primitives.vertices.empty()) return;
+    const BatchVertex* data = primitives.vertices.data();
+    glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), &data->x);
+    glColorPointer(3, GL_FLOAT, sizeof(BatchVertex), &data->r);
+    glDrawArrays(primitives.mode, 0, (GLsizei)primitives.vertices.size());
+}
+
+// Submit everything collected this frame (One draw call per primitive type and layer)
+void batchFlush() {
+    for (BatchLayer& layer : batch.layers) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+
+        // Fills first, then the '+' signs and outlines drawn on top of them
+        flushBatch(layer.triangles);
+        flushBatch(layer.lines);
+        flushBatch(layer.points);
+        rasterCountPoints(layer.points.vertices.size(), sizeof(BatchVertex));
+        if (!layer.sprites.vertices.empty()) {
+            glPointSize(LOD_SPRITE_SIZE * pixelsPerUnit());
+            flushBatch(layer.sprites);
+            glPointSize(pixelsPerUnit());
+        }
+
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        // Shader-rasterized outlines and diamonds (Empty on the CPU path)
+        if (rasterOnGpu()) rasterFlush(layer.raster);
+    }
+}
+
+// Filled circle with a fixed segment count (Reduced detail)
+void batchFilledCircleSegments(float cx, float cy, float r, int segments) {
+    const std::vector<CirclePoint>& circle = unitCircle(segments);
+    for (size_t i = 1; i < circle.size(); i++) {
+        batchVertex(batch.layer->triangles, cx, cy);
+        batchVertex(batch.layer->triangles, cx + r * circle[i - 1].x, cy + r * circle[i - 1].y);
+        batchVertex(batch.layer->triangles, cx + r * circle[i].x, cy + r * circle[i].y);
+    }
+}
+
+// Outline as line segments around count points (Reduced detail)
+void batchOutline(const CirclePoint* points, int count, float scale) {
+    for (int k = 0; k < count; k++) {
+        const CirclePoint& from = points[k];
+        const CirclePoint& to = points[(k + 1) % count];
+        batchVertex(batch.layer->lines, from.x * scale, from.y * scale);
+        batchVertex(batch.layer->lines, to.x * scale, to.y * scale);
+    }
+}
+
+// Square of half-size r around the model origin (Solid detail, rotates with the object)
+void batchSolid(float r) {
+    batchQuad(-r, -r, r, -r, r, r, -r, r);
+}
+
+// Radius of an archetype's bounding circle
+float archetypeRadius(const EnemyArchetype& kind) {
+    if (kind.shape == SHAPE_DISC) return kind.size;
+    float r = 0;
+    for (int k = 0; k < kind.pointCount; k++) {
+        r = std::max(r, (float)sqrt(kind.points[k][0] * kind.points[k][0] + kind.points[k][1] * kind.points[k][1]));
+    }
+    return r;
+}
+
+// Draw bullet (Conditional appearance based on level)
+void drawBullet(float x, float y, int level) {
+    batchTransform(0, 0, 0, 1);
+
+    // --- Determine Bullet Appearance based on Level ---
+    if (level < 3) {
+        // Level 1 or 2: Yellow (Original)
+        batchColor(1.0, 1.0, 0.0); // Yellow color
+
+        // Size: 4 units wide, 10 units tall
+        batchQuad(x - 2, y - 5, x + 2, y - 5, x + 2, y + 5, x - 2, y + 5);
+    }
+    else {
+        // Level 3 or higher: Red (Power-up look for final level)
+        batchColor(1.0, 0.0, 0.0); // Red color
+
+        // Size: 6 units wide, 14 units tall
+        batchQuad(x - 3, y - 0, x + 3, y - 1, x, y + 7, x - 3, y + 7);
+    }
+}
+
+// Emit one enemy of the given shape around the current transform (Specialized per shape,
+// so the per-enemy loop of an archetype has no shape branches; the level is the same for
+// the whole frame)
+template <EnemyShape Shape>
+void emitEnemy(const EnemyArchetype& kind, DetailLevel level) {
+    if (level == LOD_SPRITE) {
+        batchColor(kind.color[0], kind.color[1], kind.color[2]);
+        batchVertex(batch.layer->sprites, 0, 0);
+    }
+    else if (level == LOD_SOLID) {
+        batchColor(kind.color[0], kind.color[1], kind.color[2]);
+        batchSolid(archetypeRadius(kind) * 0.75f);
+    }
+    else if (level == LOD_REDUCED && Shape == SHAPE_DISC) {
+        const CirclePoint* circle = unitCircle(LOD_REDUCED_SEGMENTS).data();
+        batchColor(kind.color[0], kind.color[1], kind.color[2]);
+        batchFilledCircleSegments(0, 0, kind.size, LOD_REDUCED_SEGMENTS);
+        batchColor(kind.outline[0], kind.outline[1], kind.outline[2]);
+        batchOutline(circle, LOD_REDUCED_SEGMENTS, kind.size);
+    }
+    else if (level == LOD_REDUCED && Shape == SHAPE_OUTLINE) {
+        CirclePoint corners[8];
+        for (int k = 0; k < kind.pointCount; k++) corners[k] = { kind.points[k][0], kind.points[k][1] };
+        batchOutline(corners, kind.pointCount, 1);
+    }
+    else if (Shape == SHAPE_DISC) {
+        batchColor(kind.color[0], kind.color[1], kind.color[2]);
+        batchFilledCircle(0, 0, kind.size);
+        batchColor(kind.outline[0], kind.outline[1], kind.outline[2]);
+        batchCircleMidpoint(0, 0, kind.size);
+    }
+    else if (Shape == SHAPE_POLYGON) {
+        for (int k = 2; k < kind.pointCount; k++) {
+            batchVertex(batch.layer->triangles, kind.points[0][0], kind.points[0][1]);
+            batchVertex(batch.layer->triangles, kind.points[k - 1][0], kind.points[k - 1][1]);
+            batchVertex(batch.layer->triangles, kind.points[k][0], kind.points[k][1]);
+        }
+    }
+    else {
+        // Draw the sides using the DDA algorithm
+        for (int k = 0; k < kind.pointCount; k++) {
+            const float* from = kind.points[k];
+            const float* to = kind.points[(k + 1) % kind.pointCount];
+            batchLineDDA(from[0], from[1], to[0], to[1]);
+        }
+    }
+}
+
+// Draw every enemy of one archetype (Translation + rotation animation)
+template <EnemyShape Shape>
+void drawEnemyGroup(const EnemyArchetype& kind, const ObjectView& view, const int* order, int count,
+    float alpha, float rotation, DetailLevel level) {
+    if (Shape != SHAPE_DISC) batchColor(kind.color[0], kind.color[1], kind.color[2]);
+    for (int n = 0; n < count; n++) {
+        int i = order[n];
+        batchTransform(view.x[i], lerp(view.prevY[i], view.y[i], alpha), rotation, 1);
+        emitEnemy<Shape>(kind, level);
+    }
+}
+
+typedef void (*EnemyGroupDrawer)(const EnemyArchetype&, const ObjectView&, const int*, int, float, float, DetailLevel);
+const EnemyGroupDrawer enemyGroupDrawers[SHAPE_COUNT] = {
+    drawEnemyGroup<SHAPE_DISC>, drawEnemyGroup<SHAPE_POLYGON>, drawEnemyGroup<SHAPE_OUTLINE>
+};
+
+// Enemy indices grouped by archetype (Counting sort on type, into the frame arena).
+// Archetype t occupies order[start[t], start[t + 1]).
+const int* sortEnemiesByType(const ObjectView& view, int* start) {
+    int* order = (int*)arenaAllocate(frameArena, view.count * sizeof(int));
+    std::fill(start, start + ENEMY_ARCHETYPES + 1, 0);
+    for (int i = 0; i < view.count; i++) {
+        start[view.type[i] + 1]++;
+    }
+    for (int t = 0; t < ENEMY_ARCHETYPES; t++) {
+        start[t + 1] += start[t];
+    }
+    int fill[ENEMY_ARCHETYPES];
+    std::copy(start, start + ENEMY_ARCHETYPES, fill);
+    for (int i = 0; i < view.count; i++) {
+        order[fill[view.type[i]]++] = i;
+    }
+    return order;
+}
+
+// Draw all enemies, one group per archetype
+void drawEnemies(const ObjectView& view, float alpha, float rotation, DetailLevel level) {
+    int start[ENEMY_ARCHETYPES + 1];
+    const int* order = sortEnemiesByType(view, start);
+    for (int t = 0; t < ENEMY_ARCHETYPES; t++) {
+        int count = start[t + 1] - start[t];
+        if (count == 0) continue;
+        const EnemyArchetype& kind = enemyArchetypes[t];
+        enemyGroupDrawers[kind.shape](kind, view, order + start[t], count, alpha, rotation, level);
+    }
+}
+
+// Draw power-up (Green pulsing circle)
+void drawPowerUp(float x, float y, float scale, DetailLevel level) {
+    // Translation + scaling animation (pulsing)
+    batchTransform(x, y, 0, scale);
+
+    batchColor(0.0, 1.0, 0.0);
+    if (level == LOD_SPRITE) {
+        batchVertex(batch.layer->sprites, 0, 0);
+        return;
+    }
+    if (level == LOD_SOLID) {
+        batchSolid(8);
+        return;
+    }
+    if (level == LOD_REDUCED) batchFilledCircleSegments(0, 0, 10, LOD_REDUCED_SEGMENTS);
+    else batchFilledCircle(0, 0, 10);
+
+    // Draw '+' sign
+    batchColor(1.0, 1.0, 1.0);
+    batchVertex(batch.layer->lines, -5, 0);
+    batchVertex(batch.layer->lines, 5, 0);
+    batchVertex(batch.layer->lines, 0, -5);
+    batchVertex(batch.layer->lines, 0, 5);
+}
+
+// === INSTANCED RENDERING ===
+// With GL 3.3 shaders, enemies and power-ups are not transformed on the CPU at all.
+// Each archetype (And the power-up) has a static mesh, built once by running the same
+// batch emitters into a vertex buffer. Per frame only (x, y, type) per object is streamed;
+// the vertex shader rotates enemies, pulses power-ups from one time uniform and places
+// them. Every mesh part is one glDrawArraysInstanced call. Without shaders/instancing
+// (Or with --no-instancing, F5 at runtime) the batched path above is used instead.
+struct ObjectInstance {
+    GLfloat x, y;
+    GLfloat type; // Row of enemyArchetypes, -1 = power-up
+};
+
+// Vertex ranges of one mesh in the mesh buffer (Triangles, lines, points, sprites)
+struct InstancedMesh {
+    GLint first[4];
+    GLsizei count[4];
+};
+
+const int POWER_UP_MESH = ENEMY_ARCHETYPES;
+
+struct InstancedRenderer {
+    bool ready = false;   // Program and meshes built
+    bool enabled = true;  // --no-instancing / F5
+    GLuint program = 0;
+    GLint timeUniform = -1;
+    GLuint meshBuffer = 0;
+    GLuint instanceBuffer = 0;
+    InstancedMesh meshes[LOD_LEVEL_COUNT][ENEMY_ARCHETYPES + 1]; // One set per detail level
+    DetailLevel level = LOD_FULL;           // Meshes used by the next flush
+    ArenaArray<ObjectInstance> instances = { &frameArena }; // Enemies sorted by type, then power-ups
+    int start[ENEMY_ARCHETYPES + 2];        // First instance of each mesh
+    int drawCalls = 0;                      // Last flush (F3 overlay)
+} instanced;
+
+enum InstancedAttribute { ATTRIB_POSITION, ATTRIB_COLOR, ATTRIB_INSTANCE };
+
+// Same transform as batchTransform(): fmod(degrees, 360), pi as 3.14159, then scale
+const char* instancedVertexShader =
+    "#version 130\n"
+    "in vec2 position;\n"
+    "in vec3 color;\n"
+    "in vec3 instance;\n"
+    "uniform float time;\n"
+    "out vec3 tint;\n"
+    "void main() {\n"
+    "    bool powerUp = instance.z < 0.0;\n"
+    "    float degrees = powerUp ? 0.0 : mod(time * 0.1, 360.0);\n"
+    "    float scale = powerUp ? 1.0 + 0.2 * sin(time * 0.01) : 1.0;\n"
+    "    float angle = degrees * 3.14159 / 180.0;\n"
+    "    float c = cos(angle) * scale;\n"
+    "    float s = sin(angle) * scale;\n"
+    "    vec2 world = instance.xy + vec2(c * position.x - s * position.y, s * position.x + c * position.y);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(world, 0.0, 1.0);\n"
+    "    tint = color;\n"
+    "}\n";
+
+const char* instancedFragmentShader =
+    "#version 130\n"
+    "in vec3 tint;\n"
+    "void main() {\n"
+    "    gl_FragColor = vec4(tint, 1.0);\n"
+    "}\n";
+
+bool instancedOn() {
+    return instanced.enabled && instanced.ready;
+}
+
+// Append the current batch to the mesh vertices as one mesh
+void captureMesh(std::vector<BatchVertex>& vertices, InstancedMesh& mesh) {
+    const BatchLayer& layer = *batch.layer;
+    const PrimitiveBatch* parts[4] = { &layer.triangles, &layer.lines, &layer.points, &layer.sprites };
+    for (int p = 0; p < 4; p++) {
+        mesh.first[p] = (GLint)vertices.size();
+        mesh.count[p] = (GLsizei)parts[p]->vertices.size();
+        vertices.insert(vertices.end(), parts[p]->vertices.begin(), parts[p]->vertices.end());
+    }
+}
+
+// Needs a current GL context (Called from init, after loadGLExtensions)
+void buildInstancedRenderer() {
+    if (!glext.shaders || !glext.instancing || !glext.vertexBuffers) return;
+
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, instancedVertexShader);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, instancedFragmentShader);
+    if (!vertex || !fragment) return;
+    GLuint program = glext.createProgram();
+    glext.attachShader(program, vertex);
+    glext.attachShader(program, fragment);
+    glext.bindAttribLocation(program, ATTRIB_POSITION, "position");
+    glext.bindAttribLocation(program, ATTRIB_COLOR, "color");
+    glext.bindAttribLocation(program, ATTRIB_INSTANCE, "instance");
+    if (!linkProgram(program)) return;
+
+    // Meshes in model space, outlines rasterized once by the CPU algorithms
+    RasterMode mode = rasterMode;
+    rasterMode = RASTER_CPU;
+    std::vector<BatchVertex> vertices;
+    for (int l = 0; l < LOD_LEVEL_COUNT; l++) {
+        DetailLevel level = (DetailLevel)l;
+        for (int t = 0; t < ENEMY_ARCHETYPES; t++) {
+            const EnemyArchetype& kind = enemyArchetypes[t];
+            batchBegin();
+            batchTransform(0, 0, 0, 1);
+            batchColor(kind.color[0], kind.color[1], kind.color[2]);
+            if (kind.shape == SHAPE_DISC) emitEnemy<SHAPE_DISC>(kind, level);
+            else if (kind.shape == SHAPE_POLYGON) emitEnemy<SHAPE_POLYGON>(kind, level);
+            else emitEnemy<SHAPE_OUTLINE>(kind, level);
+            captureMesh(vertices, instanced.meshes[l][t]);
+        }
+        batchBegin();
+        drawPowerUp(0, 0, 1, level);
+        captureMesh(vertices, instanced.meshes[l][POWER_UP_MESH]);
+    }
+    batchBegin();
+    rasterMode = mode;
+
+    glext.genBuffers(1, &instanced.meshBuffer);
+    glext.bindBuffer(GL_ARRAY_BUFFER, instanced.meshBuffer);
+    glext.bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BatchVertex), vertices.data(), GL_STATIC_DRAW);
+    glext.genBuffers(1, &instanced.instanceBuffer);
+    glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    instanced.program = program;
+    instanced.timeUniform = glext.getUniformLocation(program, "time");
+    instanced.ready = true;
+}
+
+// Start the frame's instances with all enemies, grouped by archetype (Positions interpolated
+// like the batched path). Power-ups are appended after them.
+void instancedEnemies(const ObjectView& view, float alpha) {
+    int start[ENEMY_ARCHETYPES + 1];
+    const int* order = sortEnemiesByType(view, start);
+    instanced.instances.clear();
+    for (int t = 0; t < ENEMY_ARCHETYPES; t++) {
+        instanced.start[t] = start[t];
+        for (int n = start[t]; n < start[t + 1]; n++) {
+            int i = order[n];
+            instanced.instances.push_back({ view.x[i], lerp(view.prevY[i], view.y[i], alpha), (float)t });
+        }
+    }
+    instanced.start[POWER_UP_MESH] = (int)instanced.instances.size();
+    instanced.start[POWER_UP_MESH + 1] = instanced.start[POWER_UP_MESH];
+}
+
+void instancedPowerUp(float x, float y) {
+    instanced.instances.push_back({ x, y, -1 });
+    instanced.start[POWER_UP_MESH + 1]++;
+}
+
+// Stream this frame's instances and draw every mesh part (elapsed = GLUT_ELAPSED_TIME)
+void instancedFlush(float elapsed) {
+    instanced.drawCalls = 0;
+    if (instanced.instances.empty()) return;
+
+    glext.useProgram(instanced.program);
+    glext.uniform1f(instanced.timeUniform, elapsed);
+
+    // Orphan and refill the instance buffer (The driver keeps the previous one while in use)
+    size_t bytes = instanced.instances.size() * sizeof(ObjectInstance);
+    glext.bindBuffer(GL_ARRAY_BUFFER, instanced.instanceBuffer);
+    glext.bufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+    glext.bufferData(GL_ARRAY_BUFFER, bytes, instanced.instances.data(), GL_STREAM_DRAW);
+
+    glext.bindBuffer(GL_ARRAY_BUFFER, instanced.meshBuffer);
+    glext.vertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (const void*)offsetof(BatchVertex, x));
+    glext.vertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (const void*)offsetof(BatchVertex, r));
+    glext.enableVertexAttribArray(ATTRIB_POSITION);
+    glext.enableVertexAttribArray(ATTRIB_COLOR);
+    glext.enableVertexAttribArray(ATTRIB_INSTANCE);
+    glext.vertexAttribDivisor(ATTRIB_INSTANCE, 1);
+    glext.bindBuffer(GL_ARRAY_BUFFER, instanced.instanceBuffer);
+
+    const GLenum modes[4] = { GL_TRIANGLES, GL_LINES, GL_POINTS, GL_POINTS };
+    glPointSize(instanced.level == LOD_SPRITE ? LOD_SPRITE_SIZE * pixelsPerUnit() : pixelsPerUnit());
+    for (int m = 0; m <= POWER_UP_MESH; m++) {
+        int count = instanced.start[m + 1] - instanced.start[m];
+        if (count == 0) continue;
+        // Each mesh reads its own range of the instance buffer
+        glext.vertexAttribPointer(ATTRIB_INSTANCE, 3, GL_FLOAT, GL_FALSE, sizeof(ObjectInstance),
+            (const void*)(instanced.start[m] * sizeof(ObjectInstance)));
+        for (int p = 0; p < 4; p++) {
+            const InstancedMesh& mesh = instanced.meshes[instanced.level][m];
+            if (mesh.count[p] == 0) continue;
+            glext.drawArraysInstanced(modes[p], mesh.first[p], mesh.count[p], count);
+            instanced.drawCalls++;
+        }
+    }
+    glPointSize(pixelsPerUnit());
+
+    // Leave the fixed-function state as the rest of the frame expects it
+    glext.vertexAttribDivisor(ATTRIB_INSTANCE, 0);
+    glext.disableVertexAttribArray(ATTRIB_INSTANCE);
+    glext.disableVertexAttribArray(ATTRIB_COLOR);
+    glext.disableVertexAttribArray(ATTRIB_POSITION);
+    glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glext.useProgram(0);
+    instanced.instances.clear();
+}
+
+// === PARTICLES ===
+// Hit sparks and explosions. The simulation only reports effects (World::effects, in the
+// tick arena); the simulation thread hands the window world's effects to the GLUT thread
+// through a lock-free queue, and the GLUT thread owns the particles. So particles never
+// touch the game state, replays or checksums, and benchmark worlds do not pay for them.
+// The particles of a frame live in a fixed-capacity ring, as structure-of-arrays columns
+// in the layout the GPU reads: (x, y) pairs, velocities, a life fraction and an RGBA
+// colour each. A frame moves them with the SIMD integrate kernel over the flat columns
+// (position += velocity * dt, life -= fade * dt), streams the live range into one vertex
+// buffer and draws it with a single glDrawArrays of points. The shader fades a point with
+// its life and blending is additive, so particles that died inside the range add nothing.
+// A full ring overwrites its oldest particles. Needs GLSL 1.30 shaders and vertex buffers.
+const int EFFECT_QUEUE_SIZE = 1024; // Power of two
+
+struct EffectQueue {
+    Effect effects[EFFECT_QUEUE_SIZE];
+    std::atomic<uint32_t> head{ 0 }; // Next slot to write
+    std::atomic<uint32_t> tail{ 0 }; // Next slot to read
+    std::atomic<long long> dropped{ 0 }; // Effects lost to a full queue
+} effectQueue;
+
+// Simulation side: queue the effects of the tick the world just ran
+void pushEffects(const World& world) {
+    for (const Effect& effect : world.effects) {
+        uint32_t head = effectQueue.head.load(std::memory_order_relaxed);
+        if (head - effectQueue.tail.load(std::memory_order_acquire) == EFFECT_QUEUE_SIZE) {
+            effectQueue.dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        effectQueue.effects[head & (EFFECT_QUEUE_SIZE - 1)] = effect;
+        effectQueue.head.store(head + 1, std::memory_order_release);
+    }
+}
+
+bool popEffect(Effect& effect) {
+    uint32_t tail = effectQueue.tail.load(std::memory_order_relaxed);
+    if (tail == effectQueue.head.load(std::memory_order_acquire)) return false;
+    effect = effectQueue.effects[tail & (EFFECT_QUEUE_SIZE - 1)];
+    effectQueue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+struct ParticleSystem {
+    int capacity = 65536;               // --particles=N (0 = no particles)
+    std::vector<float> position;        // x, y per particle
+    std::vector<float> velocity;        // Units per second, x, y per particle
+    std::vector<float> life;            // 1 when emitted, visible while above 0
+    std::vector<float> fade;            // Life lost per second (1 / lifetime)
+    std::vector<unsigned char> color;   // RGBA per particle
+    long long head = 0, tail = 0;       // Live particles are [tail, head), indices mod capacity
+    long long overwritten = 0;          // Still alive when the ring needed their slot
+    Random rng = Random();              // Render side only, the game's generators are untouched
+
+    bool ready = false;
+    GLuint program = 0;
+    GLuint buffer = 0;
+} particles;
+
+enum ParticleAttribute { ATTRIB_PARTICLE_POSITION, ATTRIB_PARTICLE_LIFE, ATTRIB_PARTICLE_COLOR };
+
+const char* particleVertexShader =
+    "#version 130\n"
+    "in vec2 position;\n"
+    "in float life;\n"
+    "in vec4 color;\n"
+    "out vec4 tint;\n"
+    "void main() {\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 0.0, 1.0);\n"
+    "    tint = vec4(color.rgb, color.a * clamp(life, 0.0, 1.0));\n"
+    "}\n";
+
+const char* particleFragmentShader =
+    "#version 130\n"
+    "in vec4 tint;\n"
+    "void main() {\n"
+    "    gl_FragColor = tint;\n"
+    "}\n";
+
+// How each effect kind bursts: particle count, speed and lifetime ranges, colour (-1 = archetype)
+struct EffectStyle {
+    int count;
+    float speedMin, speedMax; // Units per second
+    float lifeMin, lifeMax;   // Seconds
+    float color[3];
+};
+
+const EffectStyle effectStyles[] = {
+    { 10, 60, 180, 0.15f, 0.35f, { 1.0f, 1.0f, 0.6f } },   // EFFECT_SPARK
+    { 64, 30, 220, 0.4f, 0.9f, { -1, 0, 0 } },             // EFFECT_EXPLOSION
+    { 160, 40, 320, 0.5f, 1.2f, { 1.0f, 0.5f, 0.1f } },    // EFFECT_PLAYER_HIT
+    { 32, 20, 120, 0.3f, 0.6f, { 0.3f, 1.0f, 0.3f } },     // EFFECT_PICKUP
+};
+
+// Size the ring (Window startup and the particle bench only)
+void reserveParticles() {
+    int capacity = particles.capacity;
+    particles.position.assign(2 * capacity, 0);
+    particles.velocity.assign(2 * capacity, 0);
+    particles.life.assign(capacity, 0);
+    particles.fade.assign(capacity, 0);
+    particles.color.assign(4 * capacity, 0);
+}
+
+// Needs a current GL context (Called from init, after loadGLExtensions)
+void buildParticleRenderer() {
+    if (particles.capacity == 0 || !glext.shaders || !glext.vertexBuffers) return;
+    reserveParticles();
+
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, particleVertexShader);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, particleFragmentShader);
+    if (!vertex || !fragment) return;
+    GLuint program = glext.createProgram();
+    glext.attachShader(program, vertex);
+    glext.attachShader(program, fragment);
+    glext.bindAttribLocation(program, ATTRIB_PARTICLE_POSITION, "position");
+    glext.bindAttribLocation(program, ATTRIB_PARTICLE_LIFE, "life");
+    glext.bindAttribLocation(program, ATTRIB_PARTICLE_COLOR, "color");
+    if (!linkProgram(program)) return;
+
+    glext.genBuffers(1, &particles.buffer);
+    particles.program = program;
+    particles.ready = true;
+}
+
+float randomUnit(Random& rng) {
+    return randomNext(rng) * (1.0f / 4294967296.0f);
+}
+
+// Start count particles at (x, y), flying outwards in random directions
+void emitParticles(float x, float y, const EffectStyle& style, const float* color) {
+    ParticleSystem& p = particles;
+    for (int n = 0; n < style.count; n++) {
+        if (p.head - p.tail == p.capacity) {
+            if (p.life[p.tail % p.capacity] > 0) p.overwritten++;
+            p.tail++;
+        }
+        int i = (int)(p.head++ % p.capacity);
+        float angle = randomUnit(p.rng) * 6.28318f;
+        float speed = style.speedMin + (style.speedMax - style.speedMin) * randomUnit(p.rng);
+        float lifetime = style.lifeMin + (style.lifeMax - style.lifeMin) * randomUnit(p.rng);
+        float heat = 0.6f + 0.4f * randomUnit(p.rng); // Some particles a little dimmer
+        p.position[2 * i] = x;
+        p.position[2 * i + 1] = y;
+        p.velocity[2 * i] = cosf(angle) * speed;
+        p.velocity[2 * i + 1] = sinf(angle) * speed;
+        p.life[i] = 1;
+        p.fade[i] = 1 / lifetime;
+        for (int c = 0; c < 3; c++) p.color[4 * i + c] = (unsigned char)(255 * std::min(1.0f, color[c] * heat + 0.1f));
+        p.color[4 * i + 3] = 255;
+    }
+}
+
+void emitEffect(const Effect& effect) {
+    const EffectStyle& style = effectStyles[effect.kind];
+    const float* color = style.color;
+    if (effect.kind == EFFECT_EXPLOSION) color = enemyArchetypes[std::min<int>(effect.archetype, ENEMY_ARCHETYPES - 1)].color;
+    emitParticles(effect.x, effect.y, style, color);
+}
+
+// Live range of the ring as at most two contiguous pieces (Second one after a wrap)
+int particlePieces(int begin[2], int count[2]) {
+    const ParticleSystem& p = particles;
+    int live = (int)(p.head - p.tail);
+    if (live == 0) return 0;
+    begin[0] = (int)(p.tail % p.capacity);
+    count[0] = std::min(live, p.capacity - begin[0]);
+    begin[1] = 0;
+    count[1] = live - count[0];
+    return count[1] > 0 ? 2 : 1;
+}
+
+// Advance every live particle by dt seconds and retire the oldest ones that are gone
+void updateParticles(float dt) {
+    ParticleSystem& p = particles;
+    int begin[2], count[2];
+    int pieces = particlePieces(begin, count);
+    for (int k = 0; k < pieces; k++) {
+        simd.integrate(p.position.data() + 2 * begin[k], p.velocity.data() + 2 * begin[k], 2 * count[k], dt);
+        simd.integrate(p.life.data() + begin[k], p.fade.data() + begin[k], count[k], -dt);
+    }
+    while (p.tail < p.head && p.life[p.tail % p.capacity] <= 0) p.tail++;
+}
+
+// Drop every particle and pending effect (Outside PLAYING)
+void clearParticles() {
+    Effect effect;
+    while (popEffect(effect)) {}
+    particles.tail = particles.head;
+}
+
+// One frame: emit the effects that arrived, move everything, draw the live range at once
+void particlesFrame(float dt) {
+    if (!particles.ready) {
+        clearParticles();
+        return;
+    }
+    Effect effect;
+    while (popEffect(effect)) emitEffect(effect);
+    updateParticles(dt);
+    if (particles.head == particles.tail) return;
+
+    // One buffer: all positions, then all lives, then all colours (A wrapped range is
+    // uploaded as two pieces, so the GPU still sees one contiguous run)
+    ParticleSystem& p = particles;
+    int begin[2], count[2];
+    int pieces = particlePieces(begin, count);
+    int live = (int)(p.head - p.tail);
+    size_t lifeOffset = live * 2 * sizeof(float);
+    size_t colorOffset = lifeOffset + live * sizeof(float);
+    glext.bindBuffer(GL_ARRAY_BUFFER, p.buffer);
+    glext.bufferData(GL_ARRAY_BUFFER, colorOffset + live * 4, NULL, GL_STREAM_DRAW);
+    for (int k = 0, done = 0; k < pieces; done += count[k], k++) {
+        glext.bufferSubData(GL_ARRAY_BUFFER, done * 2 * sizeof(float), count[k] * 2 * sizeof(float), p.position.data() + 2 * begin[k]);
+        glext.bufferSubData(GL_ARRAY_BUFFER, lifeOffset + done * sizeof(float), count[k] * sizeof(float), p.life.data() + begin[k]);
+        glext.bufferSubData(GL_ARRAY_BUFFER, colorOffset + done * 4, count[k] * 4, p.color.data() + 4 * begin[k]);
+    }
+
+    glext.useProgram(p.program);
+    glext.vertexAttribPointer(ATTRIB_PARTICLE_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (const void*)0);
+    glext.vertexAttribPointer(ATTRIB_PARTICLE_LIFE, 1, GL_FLOAT, GL_FALSE, 0, (const void*)lifeOffset);
+    glext.vertexAttribPointer(ATTRIB_PARTICLE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (const void*)colorOffset);
+    glext.enableVertexAttribArray(ATTRIB_PARTICLE_POSITION);
+    glext.enableVertexAttribArray(ATTRIB_PARTICLE_LIFE);
+    glext.enableVertexAttribArray(ATTRIB_PARTICLE_COLOR);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glPointSize(2 * pixelsPerUnit());
+    glDrawArrays(GL_POINTS, 0, live);
+    glPointSize(pixelsPerUnit());
+    glDisable(GL_BLEND);
+
+    // Leave the fixed-function state as the rest of the frame expects it
+    glext.disableVertexAttribArray(ATTRIB_PARTICLE_COLOR);
+    glext.disableVertexAttribArray(ATTRIB_PARTICLE_LIFE);
+    glext.disableVertexAttribArray(ATTRIB_PARTICLE_POSITION);
+    glext.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glext.useProgram(0);
+}
+
+// === IDLE RENDERING ===
+// Outside PLAYING nothing moves (Even the star scroll is frozen), so the menu and
+// game-over screens are only drawn when what they show changes: the state, the score
+// they print, or the F3 overlay. Meanwhile the GLUT idle callback is swapped for a slow
+// poll timer, and input wakes the loop at once. The static layer (Stars and text) is
+// copied from the back buffer into a texture after it is drawn, so an overlay-only
+// change restores it with one quad instead of redrawing the scene under the overlay.
+const int IDLE_POLL_MS = 100; // Poll rate while nothing changes (Profiler refreshes every 250 ms)
+
+enum IdleDamage { DAMAGE_NONE, DAMAGE_OVERLAY, DAMAGE_FULL };
+
+// Everything a MENU/GAME_OVER frame depends on
+struct IdleView {
+    GameState state = PLAYING;
+    int score = 0;
+    bool fontReady = false;
+    bool overlay = false;     // F3
+    uint32_t overlayStamp = 0; // Profiler refresh period, render toggles (Only with F3)
+};
+
+struct IdleRenderer {
+    bool enabled = true;        // --no-damage: redraw every frame, also outside PLAYING
+    bool sleeping = false;      // Idle callback replaced by the poll timer
+    int generation = 0;         // Only the newest poll timer counts (GLUT timers cannot be cancelled)
+    IdleView shown;             // What the front buffer shows (state PLAYING = nothing known)
+    IdleDamage pending = DAMAGE_FULL; // Kind of redraw gameLoop asked for (Expose events get a full one)
+    GLuint cache = 0;           // Copy of the static layer
+    bool cached = false;
+    long long frames = 0, restores = 0; // Idle redraws, and how many of them only restored the cache
+} idle;
+
+IdleView idleView(const GameSnapshot& frame) {
+    IdleView view;
+    view.state = frame.state;
+    view.score = frame.player.score;
+    view.fontReady = font.ready;
+    view.overlay = showProfiler;
+    if (showProfiler) {
+        view.overlayStamp = profileMilliseconds() / 250 * 64 + rasterMode * 16 + instanced.enabled * 8 + pacer.mode;
+    }
+    return view;
+}
+
+IdleDamage idleDamage(const IdleView& view) {
+    const IdleView& shown = idle.shown;
+    if (shown.state == PLAYING || view.state != shown.state || view.score != shown.score || view.fontReady != shown.fontReady) {
+        return DAMAGE_FULL;
+    }
+    if (view.overlay != shown.overlay || view.overlayStamp != shown.overlayStamp) {
+        return idle.cached ? DAMAGE_OVERLAY : DAMAGE_FULL;
+    }
+    return DAMAGE_NONE;
+}
+
+// Scene -> cache texture, right after the static layer is drawn (Needs NPOT textures, GL 2.0)
+void idleCacheStore() {
+    if (glext.major < 2) return;
+    if (!idle.cache) glGenTextures(1, &idle.cache);
+    glBindTexture(GL_TEXTURE_2D, idle.cache);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, renderTarget.x, renderTarget.y, renderTarget.width, renderTarget.height, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    idle.cached = true;
+}
+
+void idleCacheRestore() {
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, idle.cache);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(0, 0);
+    glTexCoord2f(1, 0); glVertex2f(playfield.width, 0);
+    glTexCoord2f(1, 1); glVertex2f(playfield.width, playfield.height);
+    glTexCoord2f(0, 1); glVertex2f(0, playfield.height);
+    glEnd();
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
+
+void gameLoop();
+
+void idlePoll(int generation) {
+    if (!idle.sleeping || generation != idle.generation) return;
+    idle.sleeping = false;
+    glutIdleFunc(gameLoop);
+}
+
+// Nothing to draw: stop spinning until the poll timer or an input event
+void idleSleep() {
+    idle.sleeping = true;
+    glutIdleFunc(NULL);
+    glutTimerFunc(IDLE_POLL_MS, idlePoll, ++idle.generation);
+    pacer.lastSwap = std::chrono::steady_clock::time_point(); // The gap is not a frame time
+}
+
+// Input callbacks: resume the loop right away (The key may change the screen)
+void idleWake() {
+    if (!idle.sleeping) return;
+    idle.sleeping = false;
+    glutIdleFunc(gameLoop);
+}
+
+// Draw HUD (Score, Lives, Level, Life Icons)
+void drawHUD(const GameSnapshot& frame) {
+    const Player& ship = frame.player;
+    static CounterLabel livesText, scoreText, levelText;
+    glColor3f(1.0, 1.0, 1.0);
+
+    // Lives, Score and Current Level Text (Cached until the value changes)
+    drawCounter(livesText, 10, playfield.height - 30, "Lives: %d", ship.lives);
+    drawCounter(scoreText, playfield.width - 120, playfield.height - 30, "Score: %d", ship.score);
+    drawCounter(levelText, playfield.width / 2 - 40, playfield.height - 30, "Level: %d", frame.level);
+
+    // Draw life icons
+    for (int i = 0; i < ship.lives; i++) {
+        glColor3f(1.0, 0.0, 0.0);
+        drawFilledCircle(20 + i * 25, playfield.height - 60, 8);
+    }
+}
+
+// Static screen text: every line is laid out once and then only redrawn
+struct ScreenLine {
+    int x, y;
+    const char* text;
+};
+
+void drawScreenLines(TextLabel* labels, const ScreenLine* lines, int count) {
+    for (int i = 0; i < count; i++) {
+        layoutLabel(labels[i], lines[i].x, lines[i].y, lines[i].text);
+        drawLabel(labels[i]);
+    }
+}
+
+// Draw menu
+void drawMenu() {
+    static const ScreenLine title[] = {
+        { playfield.width / 2 - 100, playfield.height / 2 + 50, "SPACE DEFENDER" },
+    };
+    static const ScreenLine controls[] = {
+        { playfield.width / 2 - 120, playfield.height / 2, "Press SPACE to Start" },
+        { playfield.width / 2 - 80, playfield.height / 2 - 40, "Controls:" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 70, "Arrows - Move" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 90, "SPACE - Shoot" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 110, "ESC - Quit" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 130, "A/D/W/S - Also work" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 150, "F3 - Profiler" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 170, "F4 - CPU/GPU raster" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 190, "F5 - Instancing" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 210, "F6 - Frame pacing" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 230, "F7 - Detail level" },
+        { playfield.width / 2 - 100, playfield.height / 2 - 250, "F8/F9 - Save/load" },
+    };
+    static TextLabel titleLabels[1], controlLabels[12];
+
+    glColor3f(0.0, 1.0, 1.0);
+    drawScreenLines(titleLabels, title, 1);
+
+    glColor3f(1.0, 1.0, 1.0);
+    drawScreenLines(controlLabels, controls, 12);
+}
+
+// Draw game over screen (Including requested text)
+void drawGameOver(const GameSnapshot& frame) {
+    static const ScreenLine heading[] = {
+        { playfield.width / 2 - 80, playfield.height / 2 + 70, "JOY BANGLA" }, // Requested text
+        { playfield.width / 2 - 80, playfield.height / 2 + 50, "GAME OVER" },
+    };
+    static const ScreenLine prompts[] = {
+        { playfield.width / 2 - 120, playfield.height / 2 - 40, "Press SPACE to Restart" },
+        { playfield.width / 2 - 80, playfield.height / 2 - 70, "Press ESC to Quit" },
+    };
+    static TextLabel headingLabels[2], promptLabels[2];
+    static CounterLabel scoreText;
+
+    glColor3f(1.0, 0.0, 0.0);
+    drawScreenLines(headingLabels, heading, 2);
+
+    glColor3f(1.0, 1.0, 1.0);
+    drawCounter(scoreText, playfield.width / 2 - 80, playfield.height / 2, "Final Score: %d", frame.player.score);
+    drawScreenLines(promptLabels, prompts, 2);
+}
+
+// Frame-time histogram of the current pacing mode (0 to 50 ms, one column per bucket)
+void drawFrameHistogram(float left, float bottom, float height) {
+    uint32_t peak = 1;
+    for (uint32_t count : pacer.frames.buckets) peak = std::max(peak, count);
+    glBegin(GL_LINES);
+    glColor3f(0.4, 0.4, 0.4);
+    glVertex2f(left, bottom);
+    glVertex2f(left + HISTOGRAM_BUCKETS, bottom);
+    glColor3f(1.0, 1.0, 0.0);
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (pacer.frames.buckets[i] == 0) continue;
+        glVertex2f(left + i + 0.5f, bottom);
+        glVertex2f(left + i + 0.5f, bottom + std::max(1.0f, height * pacer.frames.buckets[i] / peak));
+    }
+    glEnd();
+}
+
+// Draw profiling overlay (Toggled with F3: p50/p99 of every section over the last few seconds)
+void drawProfiler(const GameSnapshot& frame) {
+    static ProfileStats stats[PROFILE_SECTION_COUNT];
+    static uint32_t lastRefresh = 0;
+    uint32_t now = profileMilliseconds();
+    if (now - lastRefresh > 250) {
+        for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+            stats[i] = profileStats((ProfileSection)i);
+        }
+        lastRefresh = now;
+    }
+
+    glColor3f(1.0, 1.0, 0.0);
+    char line[80];
+    float y = playfield.height - 100;
+    drawText(10, y, "section     p50 / p99 ms");
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        y -= 20;
+        if (i == PROFILE_GPU && !glext.timerQuery) {
+            drawText(10, y, "GPU         not supported");
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-10s  %.2f / %.2f", profileSectionNames[i], stats[i].p50, stats[i].p99);
+        drawText(10, y, line);
+    }
+
+    y -= 20;
+    snprintf(line, sizeof(line), "objects     %d / %d / %d", frame.bullets.count, frame.enemies.count, frame.powerUps.count);
+    drawText(10, y, line);
+
+    y -= 20;
+    snprintf(line, sizeof(line), "pool miss   %lld / %lld / %lld", frame.bullets.exhausted, frame.enemies.exhausted, frame.powerUps.exhausted);
+    drawText(10, y, line);
+
+    // Peak use of the per-frame and per-tick arenas, and how often they had to grow
+    y -= 20;
+    snprintf(line, sizeof(line), "arenas      %.0f / %.0f KB, grown %lld / %lld", frameArena.peak / 1024.0,
+        world.tickArena.peak / 1024.0, frameArena.grows, world.tickArena.grows);
+    drawText(10, y, line);
+
+    // Vertex traffic of the DDA/Bresenham/midpoint primitives (Instances or plotted points)
+    y -= 20;
+    snprintf(line, sizeof(line), "raster      %s, %d %s, %.1f KB", rasterOnGpu() ? "gpu" : "cpu", rasterLastFrame.primitives,
+        rasterOnGpu() ? "prims" : "points", rasterLastFrame.bytes / 1024.0);
+    drawText(10, y, line);
+
+    y -= 20;
+    if (instancedOn()) snprintf(line, sizeof(line), "enemies     instanced, %d draws", instanced.drawCalls);
+    else snprintf(line, sizeof(line), "enemies     batched");
+    drawText(10, y, line);
+
+    y -= 20;
+    if (pacingFpsCap() > 0) snprintf(line, sizeof(line), "pacing      %s, %d fps cap", pacingModeNames[pacer.mode], pacingFpsCap());
+    else snprintf(line, sizeof(line), "pacing      %s, interval %d%s", pacingModeNames[pacer.mode], pacer.interval, pacer.intervalSet ? "" : " (driver)");
+    drawText(10, y, line);
+
+    y -= 20;
+    snprintf(line, sizeof(line), "swap        %.2f / %.2f", histogramPercentile(pacer.frames, 0.5f), histogramPercentile(pacer.frames, 0.99f));
+    drawText(10, y, line);
+
+    y -= 20;
+    snprintf(line, sizeof(line), "latency     %.2f / %.2f", histogramPercentile(pacer.latency, 0.5f), histogramPercentile(pacer.latency, 0.99f));
+    drawText(10, y, line);
+
+    y -= 20;
+    snprintf(line, sizeof(line), "idle        %lld redraws, %lld restored", idle.frames, idle.restores);
+    drawText(10, y, line);
+
+    y -= 20;
+    snprintf(line, sizeof(line), "scene       %dx%d of %dx%d%s", renderTarget.width, renderTarget.height,
+        renderTarget.viewWidth, renderTarget.viewHeight, renderTarget.offscreen ? ", offscreen" : "");
+    drawText(10, y, line);
+
+    y -= 20;
+    snprintf(line, sizeof(line), "detail      %s%s, %.1f / %.0f ms, %lld switches", detailLevelNames[lod.level],
+        lod.automatic ? " (auto)" : "", lod.costMs, lod.budgetMs, lod.switches);
+    drawText(10, y, line);
+
+    y -= 20;
+    if (particles.ready) snprintf(line, sizeof(line), "particles   %lld of %d, %lld overwritten, %lld dropped",
+        particles.head - particles.tail, particles.capacity, particles.overwritten, effectQueue.dropped.load(std::memory_order_relaxed));
+    else snprintf(line, sizeof(line), "particles   off");
+    drawText(10, y, line);
+
+    drawText(playfield.width - 10 - HISTOGRAM_BUCKETS, playfield.height - 100, "swap interval 0-50 ms");
+    drawFrameHistogram(playfield.width - 10 - HISTOGRAM_BUCKETS, playfield.height - 180, 60);
+
+    // Heap and arena memory per tag: live / peak KB, allocations last frame / worst frame
+    float x = playfield.width - 330;
+    y = playfield.height - 220;
+    drawText(x, y, "memory    live / peak KB, allocs");
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        y -= 20;
+        const MemoryCounters& counters = memoryCounters[tag];
+        snprintf(line, sizeof(line), "%-8s  %.1f / %.1f, %lld / %lld", memoryTagNames[tag],
+            counters.live.load(std::memory_order_relaxed) / 1024.0, counters.peak.load(std::memory_order_relaxed) / 1024.0,
+            memoryFrames.last[tag], memoryFrames.most[tag]);
+        drawText(x, y, line);
+    }
+}
+
+// Update game logic (One fixed tick, 60 per second)
+// Work split of the update sweeps (Smaller ranges run inline on the calling thread)
+const int SWEEP_GRAIN = 4096; // Objects per movement / contact chunk
+const int HIT_GRAIN = 128;    // Bullets per contact gathering chunk
+
+void World::update(const TickCommand& command) {
+    MemoryTagScope tag(MEMORY_ENTITIES);
+    arenaReset(tickArena);
+    NoAllocationScope steady(gameState == PLAYING);
+    if (gameState == PLAYING) {
+        ProfileScope scope(PROFILE_UPDATE, profiled);
+
+        int gameTicks = stepGameTicks();
+
+        // Shoot: a press waits for the cooldown, holding SPACE fires at the limit
+        if (legacyFire) {
+            for (int i = 0; i < command.presses; i++) fireBullet();
+        }
+        else {
+            if (command.presses > 0) fireQueued = true;
+            // A step of several game ticks can overshoot the cooldown; the overshoot counts
+            // towards the next one, so coarse steps keep the same fire rate
+            if (fireCooldown > 0) fireCooldown -= gameTicks;
+            if ((fireQueued || command.fireHeld) && fireCooldown <= 0) {
+                fireBullet();
+                fireQueued = false;
+                fireCooldown += fireCooldownTicks;
+            }
+            else if (fireCooldown < 0) {
+                fireCooldown = 0;
+            }
+        }
+
+        snapPreviousState();
+
+        // Update background animation
+        starOffset += 0.5 * stepScale;
+        if (starOffset > playfield.height) starOffset = 0;
+
+        // Level-ups, the no-hit penalty and spawns (Timed events due in the game ticks of this step)
+        for (int t = 0; t < gameTicks; t++) {
+            runDueEvents();
+        }
+
+        // Update player position from this tick's movement
+        float step = player.speed * stepScale;
+        if (command.move & INTENT_LEFT) {
+            player.x -= step;
+            if (player.x < player.size) player.x = player.size;
+        }
+        if (command.move & INTENT_RIGHT) {
+            player.x += step;
+            if (player.x > playfield.width - player.size) player.x = playfield.width - player.size;
+        }
+        if (command.move & INTENT_UP) {
+            player.y += step;
+            if (player.y > playfield.height - player.size) player.y = playfield.height - player.size;
+        }
+        if (command.move & INTENT_DOWN) {
+            player.y -= step;
+            if (player.y < player.size) player.y = player.size;
+        }
+
+        // Move bullets, enemies and power-ups (Linear sweep, then cull the ones that left
+        // the screen). The three systems are independent, so their chunks run as one job group.
+        const float noLimit = std::numeric_limits<float>::infinity();
+        int culled[3][MAX_JOB_CHUNKS] = {};
+        auto moveBullets = [&](int chunk, int begin, int end) {
+            simd.integrate(bullets.y.data() + begin, bullets.speed.data() + begin, end - begin, stepScale);
+            culled[0][chunk] = simd.cullOutside(bullets.y.data() + begin, end - begin, -noLimit, playfield.height, bullets.killed.data() + begin);
+        };
+        auto moveEnemies = [&](int chunk, int begin, int end) {
+            simd.integrate(enemies.y.data() + begin, enemies.speed.data() + begin, end - begin, -stepScale);
+            culled[1][chunk] = simd.cullOutside(enemies.y.data() + begin, end - begin, -30, noLimit, enemies.killed.data() + begin);
+        };
+        auto movePowerUps = [&](int chunk, int begin, int end) {
+            simd.integrate(powerUps.y.data() + begin, powerUps.speed.data() + begin, end - begin, -stepScale);
+            culled[2][chunk] = simd.cullOutside(powerUps.y.data() + begin, end - begin, -20, noLimit, powerUps.killed.data() + begin);
+        };
+        JobGroup movement;
+        jobSubmit(movement, bullets.count, SWEEP_GRAIN, moveBullets);
+        jobSubmit(movement, enemies.count, SWEEP_GRAIN, moveEnemies);
+        jobSubmit(movement, powerUps.count, SWEEP_GRAIN, movePowerUps);
+        jobWait(movement);
+        auto cleanupStart = std::chrono::steady_clock::now();
+        EntityStore* moved[3] = { &bullets, &enemies, &powerUps };
+        for (int s = 0; s < 3; s++) {
+            int total = 0;
+            for (int c = 0; c < MAX_JOB_CHUNKS; c++) total += culled[s][c];
+            if (total) entityRemoveKilled(*moved[s]);
+        }
+        auto collisionStart = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration cleanup = collisionStart - cleanupStart;
+
+        // Motion bounds of this step for the swept tests (Zero with endpoint-only tests)
+        float playerStep = sweptContacts ? fabsf(player.x - player.prevX) + fabsf(player.y - player.prevY) : 0;
+        float enemyStep = sweptContacts ? maxStep(enemies) : 0;
+
+        // Check enemy collision with player (Marks the enemies it hits as killed)
+        // The SIMD sweep uses the largest archetype radius, widened by how far the player and
+        // the enemies moved; candidates are refined per archetype along their motion.
+        static const float crashBound = maxCrashRadius();
+        float contact = player.size + crashBound + playerStep + enemyStep;
+        int contacts[MAX_JOB_CHUNKS] = {};
+        parallelFor(enemies.count, SWEEP_GRAIN, [&](int chunk, int begin, int end) {
+            contacts[chunk] = simd.withinRadius(enemies.x.data() + begin, enemies.y.data() + begin, end - begin,
+                player.x, player.y, contact * contact, enemies.killed.data() + begin);
+            });
+        int crashes = 0;
+        for (int c = 0; c < MAX_JOB_CHUNKS; c++) crashes += contacts[c];
+        for (int i = 0; crashes > 0 && i < enemies.count; i++) {
+            if (!enemies.killed[i]) continue;
+            const EnemyArchetype& kind = enemyArchetypes[enemies.type[i]];
+            float r = player.size + kind.crashRadius;
+            bool hit;
+            if (sweptContacts) {
+                hit = sweptWithinRadius(player.prevX, player.prevY, player.x, player.y,
+                    enemies.x[i], enemies.prevY[i], enemies.x[i], enemies.y[i], r);
+            }
+            else {
+                hit = kind.crashRadius == crashBound || withinRadius(player.x, player.y, enemies.x[i], enemies.y[i], r);
+            }
+            if (!hit) {
+                enemies.killed[i] = 0;
+                crashes--;
+            }
+            else {
+                effects.push_back({ EFFECT_EXPLOSION, (unsigned char)enemies.type[i], enemies.x[i], enemies.y[i] });
+            }
+        }
+        if (crashes > 0) {
+            effects.push_back({ EFFECT_PLAYER_HIT, 0, player.x, player.y });
+            player.lives -= crashes;
+            if (player.lives <= 0) {
+                gameState = GAME_OVER;
+            }
+        }
+
+        // Broad-phase grid of this tick's enemy positions
+        gridBuild(enemyGrid, enemies.count, [&](int i, float& x, float& y) {
+            x = enemies.x[i];
+            y = enemies.y[i];
+            });
+
+        // Check bullet-enemy collision (Moves lastHitTick)
+        // Chunks of bullets gather their contacts in parallel; the contacts are then applied
+        // serially in bullet order, which gives the same result as one sequential pass.
+        // Swept: a bullet's query covers its whole path this step, widened by the farthest any
+        // enemy moved, and each candidate pair is tested along both motions.
+        static const float hitBound = maxHitRadius();
+        parallelFor(bullets.count, HIT_GRAIN, [&](int chunk, int begin, int end) {
+            ArenaArray<HitPair>& found = hitPairs[chunk];
+            found.clear();
+            for (int b = begin; b < end; b++) {
+                float bx = bullets.x[b];
+                float by = bullets.y[b];
+                if (!sweptContacts) {
+                    gridQuery(enemyGrid, bx, by, hitBound, [&](int i) {
+                        if (withinRadius(bx, by, enemies.x[i], enemies.y[i], enemyArchetypes[enemies.type[i]].hitRadius)) { // Collision Radius
+                            found.push_back({ b, i });
+                        }
+                        });
+                    continue;
+                }
+                float from = bullets.prevY[b];
+                float reach = hitBound + fabsf(by - from) / 2 + enemyStep;
+                gridQuery(enemyGrid, bx, (from + by) / 2, reach, [&](int i) {
+                    if (sweptWithinRadius(bx, from, bx, by, enemies.x[i], enemies.prevY[i], enemies.x[i], enemies.y[i],
+                        enemyArchetypes[enemies.type[i]].hitRadius)) {
+                        found.push_back({ b, i });
+                    }
+                    });
+            }
+            });
+        for (int c = 0; c < MAX_JOB_CHUNKS; c++) {
+            for (const HitPair& hit : hitPairs[c]) {
+                if (!enemies.killed[hit.enemy]) {
+                    bullets.killed[hit.bullet] = 1;
+                    enemies.killed[hit.enemy] = 1;
+                    player.score += enemyArchetypes[enemies.type[hit.enemy]].score;
+                    // Restart the no-hit penalty on a successful hit
+                    lastHitTick = scheduler.now;
+                    effects.push_back({ EFFECT_SPARK, 0, bullets.x[hit.bullet], bullets.y[hit.bullet] });
+                    effects.push_back({ EFFECT_EXPLOSION, (unsigned char)enemies.type[hit.enemy], enemies.x[hit.enemy], enemies.y[hit.enemy] });
+                }
+            }
+            hitPairs[c].clear();
+        }
+
+        // Check power-up collision with player
+        float pickup = player.size + 10;
+        float pickupReach = pickup + (sweptContacts ? playerStep + maxStep(powerUps) : 0);
+        int collected = simd.withinRadius(powerUps.x.data(), powerUps.y.data(), powerUps.count,
+            player.x, player.y, pickupReach * pickupReach, powerUps.killed.data());
+        for (int i = 0; sweptContacts && collected > 0 && i < powerUps.count; i++) {
+            if (powerUps.killed[i] && !sweptWithinRadius(player.prevX, player.prevY, player.x, player.y,
+                powerUps.x[i], powerUps.prevY[i], powerUps.x[i], powerUps.y[i], pickup)) {
+                powerUps.killed[i] = 0;
+                collected--;
+            }
+        }
+        for (int i = 0; i < collected; i++) {
+            if (player.lives < 5) player.lives++; // Max 5 lives
+            player.score += 20;
+        }
+        for (int i = 0; collected > 0 && i < powerUps.count; i++) {
+            if (powerUps.killed[i]) effects.push_back({ EFFECT_PICKUP, 0, powerUps.x[i], powerUps.y[i] });
+        }
+
+        // Remove objects hit this tick (Swap-and-pop)
+        cleanupStart = std::chrono::steady_clock::now();
+        entityRemoveKilled(bullets);
+        entityRemoveKilled(enemies);
+        entityRemoveKilled(powerUps);
+        if (profiled) {
+            auto end = std::chrono::steady_clock::now();
+            profileRecord(PROFILE_COLLISIONS, cleanupStart - collisionStart);
+            profileRecord(PROFILE_CLEANUP, cleanup + (end - cleanupStart));
+        }
+    }
+}
+
+// === REPLAYS ===
+// A replay is the seed plus the input of every tick, which is enough to rerun a
+// session exactly. Records are appended to in-memory chunks on the simulation
+// thread; full chunks are handed to a writer thread, so recording never waits on disk.
+//
+// File layout (Integers little-endian, varint = LEB128):
+//   header  "SDRP", u16 version, u16 ticks per second, u64 seed,
+//           u16 forced spawn rate (0 = by level), u16 spawn burst,
+//           varint bullet, enemy and power-up pool sizes
+//           varint wave count, per wave varint tick, count, archetype + 1, interval (Version 2)
+//           varint fire cooldown in ticks (Version 3)
+//           varint playfield width, height (Version 4; older files are 800x600)
+//   record  varint ticks since the previous record, u8 key bits, varint SPACE presses
+//   end     varint ticks since the previous record, u8 REPLAY_END
+// Key bits: 1 left, 2 right, 4 up, 8 down, 16 SPACE held (Version 3; the InputIntent of
+// the tick). A record is only written for ticks where the key bits changed or SPACE was
+// pressed. Ticks count from program start (In MENU). Versions 1 and 2 were recorded
+// before the fire rate limiter and play back with every press firing at once.
+// Versions 1-4 were recorded at 60 Hz with endpoint-only contact tests and replay that
+// way; version 5 records may use any tick rate (The ticks above are then steps).
+const uint16_t REPLAY_VERSION = 5; // Version 1 (No waves) to 4 files still play
+const unsigned char REPLAY_END = 0xFF;
+const size_t REPLAY_CHUNK_SIZE = 64 * 1024;
+
+struct ReplayRecorder {
+    FILE* file = NULL;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::vector<unsigned char>> pending; // Full chunks waiting for the writer thread
+    std::vector<std::vector<unsigned char>> spare;   // Written chunks, reused
+    std::vector<unsigned char> chunk;                // Being filled by the simulation thread
+    bool closing = false;
+    long long lastTick = 0;
+    unsigned char lastBits = 0;
+} recorder;
+
+void putVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+void putLittleEndian(std::vector<unsigned char>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back((unsigned char)(value >> (8 * i)));
+    }
+}
+
+void replayWriterThread() {
+    MemoryTagScope tag(MEMORY_REPLAY);
+    std::unique_lock<std::mutex> lock(recorder.mutex);
+    while (true) {
+        recorder.wake.wait(lock, [] { return !recorder.pending.empty() || recorder.closing; });
+        if (recorder.pending.empty()) return;
+
+        std::vector<unsigned char> chunk = std::move(recorder.pending.front());
+        recorder.pending.erase(recorder.pending.begin());
+        lock.unlock();
+        fwrite(chunk.data(), 1, chunk.size(), recorder.file);
+        chunk.clear();
+        lock.lock();
+        recorder.spare.push_back(std::move(chunk));
+    }
+}
+
+// Hand the current chunk to the writer thread and continue in a recycled one
+void replayHandOff() {
+    MemoryTagScope tag(MEMORY_REPLAY);
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    recorder.pending.push_back(std::move(recorder.chunk));
+    if (!recorder.spare.empty()) {
+        recorder.chunk = std::move(recorder.spare.back());
+        recorder.spare.pop_back();
+    }
+    else {
+        recorder.chunk = std::vector<unsigned char>();
+        recorder.chunk.reserve(REPLAY_CHUNK_SIZE + 32);
+    }
+    recorder.wake.notify_one();
+}
+
+bool replayStartRecording(const char* path, uint64_t seed) {
+    MemoryTagScope tag(MEMORY_REPLAY);
+    recorder.file = fopen(path, "wb");
+    if (!recorder.file) {
+        fprintf(stderr, "Cannot write replay '%s'\n", path);
+        return false;
+    }
+    recorder.chunk.reserve(REPLAY_CHUNK_SIZE + 32);
+    recorder.pending.reserve(8);
+    recorder.chunk.insert(recorder.chunk.end(), { 'S', 'D', 'R', 'P' });
+    putLittleEndian(recorder.chunk, REPLAY_VERSION, 2);
+    putLittleEndian(recorder.chunk, tickRate, 2);
+    putLittleEndian(recorder.chunk, seed, 8);
+    putLittleEndian(recorder.chunk, forcedSpawnRate, 2);
+    putLittleEndian(recorder.chunk, spawnBurst, 2);
+    putVarint(recorder.chunk, poolConfig.bullets);
+    putVarint(recorder.chunk, poolConfig.enemies);
+    putVarint(recorder.chunk, poolConfig.powerUps);
+    putVarint(recorder.chunk, waveScripts.size());
+    for (const WaveScript& wave : waveScripts) {
+        putVarint(recorder.chunk, wave.tick);
+        putVarint(recorder.chunk, wave.count);
+        putVarint(recorder.chunk, wave.archetype + 1);
+        putVarint(recorder.chunk, wave.interval);
+    }
+    putVarint(recorder.chunk, fireCooldownTicks);
+    putVarint(recorder.chunk, playfield.width);
+    putVarint(recorder.chunk, playfield.height);
+    recorder.lastTick = 0;
+    recorder.lastBits = 0;
+    recorder.writer = std::thread(replayWriterThread);
+    return true;
+}
+
+// Called once per tick after its input was applied (Simulation thread)
+void replayRecordTick(long long tick, unsigned char bits, int presses) {
+    if (!recorder.file || (bits == recorder.lastBits && presses == 0)) return;
+    MemoryTagScope tag(MEMORY_REPLAY);
+
+    putVarint(recorder.chunk, tick - recorder.lastTick);
+    recorder.chunk.push_back(bits);
+    putVarint(recorder.chunk, presses);
+    recorder.lastTick = tick;
+    recorder.lastBits = bits;
+    if (recorder.chunk.size() >= REPLAY_CHUNK_SIZE) replayHandOff();
+}
+
+// Write the end marker after the last recorded tick and wait for the writer to finish
+void replayStopRecording(long long ticks) {
+    if (!recorder.file) return;
+    MemoryTagScope tag(MEMORY_REPLAY);
+
+    putVarint(recorder.chunk, ticks - recorder.lastTick);
+    recorder.chunk.push_back(REPLAY_END);
+    replayHandOff();
+    {
+        std::lock_guard<std::mutex> lock(recorder.mutex);
+        recorder.closing = true;
+        recorder.wake.notify_one();
+    }
+    recorder.writer.join();
+    fclose(recorder.file);
+    recorder.file = NULL;
+}
+
+struct Replay {
+    uint64_t seed = 0;
+    int tickRate = GAME_TICK_RATE;
+    int forcedSpawnRate = 0;
+    int spawnBurst = 1;
+    PoolConfig pools;
+    std::vector<WaveScript> waves;
+    int fireCooldown = 0;
+    bool legacyFire = false;         // Version 1-2: recorded before the fire rate limiter
+    bool sweptContacts = true;       // Version 1-4: recorded with endpoint-only contact tests
+    Playfield playfield;
+    std::vector<unsigned char> data; // Records (Header already parsed)
+    size_t cursor = 0;
+};
+
+bool getVarint(Replay& replay, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && replay.cursor < replay.data.size(); shift += 7) {
+        unsigned char byte = replay.data[replay.cursor++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool replayLoad(const char* path, Replay& replay) {
+    MemoryTagScope tag(MEMORY_REPLAY);
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot read replay '%s'\n", path);
+        return false;
+    }
+    unsigned char header[20];
+    bool valid = fread(header, 1, sizeof(header), file) == sizeof(header) && memcmp(header, "SDRP", 4) == 0;
+    int version = header[4] | header[5] << 8;
+    int tickRate = header[6] | header[7] << 8;
+    bool rateValid = tickRate >= MIN_TICK_RATE && tickRate <= MAX_TICK_RATE && (version >= 5 || tickRate == GAME_TICK_RATE);
+    if (!valid || version < 1 || version > REPLAY_VERSION || !rateValid) {
+        fprintf(stderr, "'%s' is not a version 1-%d replay at a supported tick rate\n", path, REPLAY_VERSION);
+        fclose(file);
+        return false;
+    }
+    replay.seed = 0;
+    for (int i = 0; i < 8; i++) {
+        replay.seed |= (uint64_t)header[8 + i] << (8 * i);
+    }
+    replay.tickRate = tickRate;
+    replay.forcedSpawnRate = header[16] | header[17] << 8;
+    replay.spawnBurst = header[18] | header[19] << 8;
+
+    unsigned char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        replay.data.insert(replay.data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+    replay.cursor = 0;
+
+    uint64_t bullets = 0, enemies = 0, powerUps = 0;
+    bool complete = getVarint(replay, bullets) && getVarint(replay, enemies) && getVarint(replay, powerUps)
+        && bullets > 0 && enemies > 0 && powerUps > 0;
+    replay.pools.bullets = (int)bullets;
+    replay.pools.enemies = (int)enemies;
+    replay.pools.powerUps = (int)powerUps;
+    uint64_t waves = 0;
+    complete = complete && (version < 2 || getVarint(replay, waves));
+    for (uint64_t i = 0; complete && i < waves; i++) {
+        uint64_t tick, count, archetype, interval;
+        complete = getVarint(replay, tick) && getVarint(replay, count) && getVarint(replay, archetype)
+            && getVarint(replay, interval);
+        if (!complete) break;
+        replay.waves.push_back({ (long long)tick, (int)count, (int)archetype - 1, (int)interval });
+    }
+    uint64_t cooldown = 0;
+    complete = complete && (version < 3 || getVarint(replay, cooldown));
+    replay.fireCooldown = (int)cooldown;
+    replay.legacyFire = version < 3;
+    replay.sweptContacts = version >= 5;
+    uint64_t width = 800, height = 600;
+    complete = complete && (version < 4 || (getVarint(replay, width) && getVarint(replay, height)));
+    replay.playfield.width = (int)width;
+    replay.playfield.height = (int)height;
+    if (!complete) fprintf(stderr, "Replay '%s' is truncated\n", path);
+    return complete;
+}
+
+// === SAVE STATES ===
+// A SaveState is an exact copy of a world's simulation state between two ticks (No
+// per-tick scratch, no render-only fields). save() and load() copy into and out of
+// storage sized once for full pools, so taking or restoring one never allocates.
+// encodeSnapshot() writes it in a compact versioned format, whole or as a delta against
+// an earlier state the reader also has (Rollback, network sync); decodeSnapshot()
+// rebuilds the identical state, so a loaded world continues exactly like the original.
+//
+// Snapshot layout (varint = LEB128, signed values zigzag):
+//   header  "SS", u8 version, u8 flags (1 = delta); delta: varint tick of the base state
+//   world   varint tick, u8 game state, varint level, shape, lives, score, fire cooldown,
+//           u8 fire queued, varint step carry, u64 rng state; full only: u64 seed, rng increment
+//           value player x, y, size, speed, star offset
+//           varint ticks since the last spawn, since the last hit, pool misses x3
+//   events  varint scheduler tick, dropped, wheel events, heap events, then per event
+//           varint ticks until due, u8 kind | 8 if cancelled (Waves: varint count,
+//           archetype + 1, interval), and varint pending spawn event + 1 (In that order)
+//   objects bullets, enemies, power-ups: varint count, per object value x, y, speed
+//           (Enemies: varint type, xor the predicted type)
+// A value is fixed point in 1/SNAPSHOT_UNIT units, written as the zigzag difference to
+// a prediction (The base state moved on by its speed, or the object before it), shifted
+// left by one. Bit 0 marks a value fixed point cannot hold exactly; its raw float bytes
+// follow instead. Moving objects of a delta then cost about one byte per value.
+const unsigned char SNAPSHOT_VERSION = 1;
+const unsigned char SNAPSHOT_DELTA = 1;
+const float SNAPSHOT_UNIT = 256;
+
+struct SavedObjects {
+    std::vector<float> x, y, speed;
+    std::vector<int> type;
+    int count = 0;
+    long long exhausted = 0;
+};
+
+struct SavedEvent {
+    long long due;
+    unsigned char kind;
+    bool cancelled;
+    int count, archetype, interval;
+};
+
+struct SaveState {
+    long long tick = -1; // -1 = empty
+    GameState state = MENU;
+    Player player = Player();
+    float starOffset = 0;
+    int currentLevel = 1, playerShape = 0;
+    int fireCooldown = 0;
+    bool fireQueued = false;
+    int stepCarry = 0;
+    Random rng = Random();
+    uint64_t seed = 0;
+    long long lastSpawnTick = 0, lastHitTick = 0;
+
+    // Pending events: the wheel slot lists in slot order, then the heap in array order
+    long long schedulerNow = 0, schedulerDropped = 0;
+    SavedEvent events[MAX_EVENTS];
+    int wheelEvents = 0, heapEvents = 0;
+    int spawnEvent = -1; // Position of enemySpawnEvent in events
+
+    SavedObjects bullets, enemies, powerUps;
+};
+
+void reserveSavedObjects(SavedObjects& objects, int capacity) {
+    objects.x.assign(capacity, 0);
+    objects.y.assign(capacity, 0);
+    objects.speed.assign(capacity, 0);
+    objects.type.assign(capacity, 0);
+}
+
+// Size a save state for full pools (Startup only)
+void reserveSaveState(SaveState& state) {
+    reserveSavedObjects(state.bullets, poolConfig.bullets);
+    reserveSavedObjects(state.enemies, poolConfig.enemies);
+    reserveSavedObjects(state.powerUps, poolConfig.powerUps);
+}
+
+void saveObjects(SavedObjects& objects, const EntityStore& store) {
+    objects.count = store.count;
+    objects.exhausted = store.exhausted;
+    std::copy(store.x.begin(), store.x.begin() + store.count, objects.x.begin());
+    std::copy(store.y.begin(), store.y.begin() + store.count, objects.y.begin());
+    std::copy(store.speed.begin(), store.speed.begin() + store.count, objects.speed.begin());
+    std::copy(store.type.begin(), store.type.begin() + store.count, objects.type.begin());
+}
+
+// Objects start the next tick at rest for interpolation (prevY is rewritten before any use)
+void loadObjects(EntityStore& store, const SavedObjects& objects) {
+    store.count = std::min(objects.count, store.capacity);
+    store.exhausted = objects.exhausted;
+    std::copy(objects.x.begin(), objects.x.begin() + store.count, store.x.begin());
+    std::copy(objects.y.begin(), objects.y.begin() + store.count, store.y.begin());
+    std::copy(objects.y.begin(), objects.y.begin() + store.count, store.prevY.begin());
+    std::copy(objects.speed.begin(), objects.speed.begin() + store.count, store.speed.begin());
+    std::copy(objects.type.begin(), objects.type.begin() + store.count, store.type.begin());
+    std::fill(store.killed.begin(), store.killed.begin() + store.count, 0);
+}
+
+void World::save(SaveState& state) const {
+    state.tick = tick;
+    state.state = gameState;
+    state.player = player;
+    state.starOffset = starOffset;
+    state.currentLevel = currentLevel;
+    state.playerShape = playerShape;
+    state.fireCooldown = fireCooldown;
+    state.fireQueued = fireQueued;
+    state.stepCarry = stepCarry;
+    state.rng = rng;
+    state.seed = seed;
+    state.lastSpawnTick = lastSpawnTick;
+    state.lastHitTick = lastHitTick;
+
+    // Event indices are not kept, only the order within each slot list and the heap layout
+    state.schedulerNow = scheduler.now;
+    state.schedulerDropped = scheduler.dropped;
+    state.spawnEvent = -1;
+    int count = 0;
+    auto keep = [&](int index) {
+        const TimedEvent& event = scheduler.events[index];
+        if (index == enemySpawnEvent) state.spawnEvent = count;
+        state.events[count++] = { event.due, (unsigned char)event.kind, event.cancelled,
+            event.count, event.archetype, event.interval };
+    };
+    for (int word = 0; word < WHEEL_SLOTS / 64; word++) {
+        for (int bit = 0; bit < 64 && scheduler.occupied[word] >> bit; bit++) {
+            if (!(scheduler.occupied[word] >> bit & 1)) continue;
+            int slot = word * 64 + bit;
+            for (int k = 0; k < EVENT_KINDS; k++) {
+                for (int index = scheduler.head[slot][k]; index >= 0; index = scheduler.events[index].next) keep(index);
+            }
+        }
+    }
+    state.wheelEvents = count;
+    for (int index : scheduler.later) keep(index);
+    state.heapEvents = count - state.wheelEvents;
+
+    saveObjects(state.bullets, bullets);
+    saveObjects(state.enemies, enemies);
+    saveObjects(state.powerUps, powerUps);
+}
+
+void World::load(const SaveState& state) {
+    tick = state.tick;
+    gameState = state.state;
+    player = state.player;
+    starOffset = state.starOffset;
+    currentLevel = state.currentLevel;
+    playerShape = state.playerShape;
+    fireCooldown = state.fireCooldown;
+    fireQueued = state.fireQueued;
+    stepCarry = state.stepCarry;
+    rng = state.rng;
+    seed = state.seed;
+    lastSpawnTick = state.lastSpawnTick;
+    lastHitTick = state.lastHitTick;
+
+    schedulerClear();
+    scheduler.now = state.schedulerNow;
+    scheduler.dropped = state.schedulerDropped;
+    enemySpawnEvent = -1;
+    for (int i = 0; i < state.wheelEvents + state.heapEvents && scheduler.freeList >= 0; i++) {
+        const SavedEvent& saved = state.events[i];
+        int index = scheduler.freeList;
+        TimedEvent& event = scheduler.events[index];
+        scheduler.freeList = event.next;
+        event.due = saved.due;
+        event.kind = (EventKind)saved.kind;
+        event.cancelled = saved.cancelled;
+        event.count = saved.count;
+        event.archetype = saved.archetype;
+        event.interval = saved.interval;
+        if (i < state.wheelEvents) wheelInsert(index);
+        else scheduler.later.push_back(index); // Already in heap order
+        if (i == state.spawnEvent) enemySpawnEvent = index;
+    }
+
+    loadObjects(bullets, state.bullets);
+    loadObjects(enemies, state.enemies);
+    loadObjects(powerUps, state.powerUps);
+    snapPreviousState();
+}
+
+// Bounded output of encodeSnapshot() (Counts past the end, so an overflow is detected once)
+struct SnapshotWriter {
+    unsigned char* data;
+    size_t capacity;
+    size_t size = 0;
+
+    void byte(unsigned char value) {
+        if (size < capacity) data[size] = value;
+        size++;
+    }
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            byte((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        byte((unsigned char)value);
+    }
+    void signedVarint(long long value) { varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63)); }
+    void raw(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) byte((unsigned char)(value >> (8 * i)));
+    }
+
+    // Fixed point difference to the prediction, or the exact float bits
+    void value(float v, float predicted) {
+        float scaled = v * SNAPSHOT_UNIT;
+        long long q = fabsf(scaled) < 1e9f ? llrintf(scaled) : 0;
+        float back = (float)q / SNAPSHOT_UNIT;
+        if (memcmp(&back, &v, sizeof(v)) != 0) {
+            uint32_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            byte(1);
+            raw(bits, 4);
+            return;
+        }
+        long long delta = q - llrintf(predicted * SNAPSHOT_UNIT);
+        varint((((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63)) << 1);
+    }
+};
+
+struct SnapshotReader {
+    const unsigned char* data;
+    size_t size;
+    size_t cursor = 0;
+    bool failed = false;
+
+    unsigned char byte() {
+        if (cursor < size) return data[cursor++];
+        failed = true;
+        return 0;
+    }
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            unsigned char b = byte();
+            value |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        failed = true;
+        return 0;
+    }
+    long long signedVarint() {
+        uint64_t value = varint();
+        return (long long)(value >> 1) ^ -(long long)(value & 1);
+    }
+    uint64_t raw(int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) value |= (uint64_t)byte() << (8 * i);
+        return value;
+    }
+    float value(float predicted) {
+        uint64_t tag = varint();
+        if (tag & 1) {
+            uint32_t bits = (uint32_t)raw(4);
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            return v;
+        }
+        uint64_t zigzag = tag >> 1;
+        long long delta = (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+        return (float)(llrintf(predicted * SNAPSHOT_UNIT) + delta) / SNAPSHOT_UNIT;
+    }
+};
+
+// Where an object is expected to be: the same slot of the base moved on by ticks steps,
+// or (No base slot) the object before it in this snapshot
+struct ObjectPrediction {
+    const SavedObjects* base;
+    float direction; // Distance per unit of speed from the base to this snapshot
+    bool typed;      // Enemies: also the archetype
+};
+
+float predictedX(const ObjectPrediction& p, const SavedObjects& objects, int i) {
+    return i < p.base->count ? p.base->x[i] : i > 0 ? objects.x[i - 1] : 0;
+}
+
+float predictedY(const ObjectPrediction& p, const SavedObjects& objects, int i) {
+    return i < p.base->count ? p.base->y[i] + p.direction * p.base->speed[i] : i > 0 ? objects.y[i - 1] : 0;
+}
+
+float predictedSpeed(const ObjectPrediction& p, const SavedObjects& objects, int i) {
+    return i < p.base->count ? p.base->speed[i] : i > 0 ? objects.speed[i - 1] : 0;
+}
+
+int predictedType(const ObjectPrediction& p, const SavedObjects& objects, int i) {
+    return i < p.base->count ? p.base->type[i] : i > 0 ? objects.type[i - 1] : 0;
+}
+
+void writeObjects(SnapshotWriter& out, const SavedObjects& objects, const ObjectPrediction& p) {
+    out.varint(objects.count);
+    for (int i = 0; i < objects.count; i++) {
+        out.value(objects.x[i], predictedX(p, objects, i));
+        out.value(objects.y[i], predictedY(p, objects, i));
+        out.value(objects.speed[i], predictedSpeed(p, objects, i));
+        if (p.typed) out.varint(objects.type[i] ^ predictedType(p, objects, i));
+    }
+}
+
+bool readObjects(SnapshotReader& in, SavedObjects& objects, const ObjectPrediction& p) {
+    uint64_t count = in.varint();
+    if (count > objects.x.size()) return false;
+    objects.count = (int)count;
+    for (int i = 0; i < objects.count && !in.failed; i++) {
+        objects.x[i] = in.value(predictedX(p, objects, i));
+        objects.y[i] = in.value(predictedY(p, objects, i));
+        objects.speed[i] = in.value(predictedSpeed(p, objects, i));
+        objects.type[i] = p.typed ? (int)in.varint() ^ predictedType(p, objects, i) : 0;
+    }
+    return !in.failed;
+}
+
+// Encode state into out (Delta against base when base is an earlier state of the same
+// session, whole otherwise). Returns the size, or 0 when it does not fit into capacity.
+size_t encodeSnapshot(const SaveState& state, const SaveState* base, unsigned char* data, size_t capacity) {
+    static const SaveState empty = SaveState();
+    bool delta = base && base->tick >= 0 && base->tick < state.tick && base->seed == state.seed
+        && base->rng.increment == state.rng.increment;
+    const SaveState& from = delta ? *base : empty;
+    long long ticks = delta ? state.tick - base->tick : 0;
+    float steps = ticks * stepScale;
+
+    SnapshotWriter out = { data, capacity };
+    out.byte('S');
+    out.byte('S');
+    out.byte(SNAPSHOT_VERSION);
+    out.byte(delta ? SNAPSHOT_DELTA : 0);
+    if (delta) out.varint(base->tick);
+
+    out.varint(state.tick);
+    out.byte((unsigned char)state.state);
+    out.varint(state.currentLevel);
+    out.varint(state.playerShape);
+    out.signedVarint(state.player.lives);
+    out.signedVarint(state.player.score);
+    out.signedVarint(state.fireCooldown);
+    out.byte(state.fireQueued);
+    out.varint(state.stepCarry);
+    out.raw(state.rng.state, 8);
+    if (!delta) {
+        out.raw(state.seed, 8);
+        out.raw(state.rng.increment, 8);
+    }
+    out.value(state.player.x, from.player.x);
+    out.value(state.player.y, from.player.y);
+    out.value(state.player.size, from.player.size);
+    out.value(state.player.speed, from.player.speed);
+    out.value(state.starOffset, from.starOffset + 0.5f * steps);
+    out.signedVarint(state.schedulerNow - state.lastSpawnTick);
+    out.signedVarint(state.schedulerNow - state.lastHitTick);
+    out.varint(state.bullets.exhausted);
+    out.varint(state.enemies.exhausted);
+    out.varint(state.powerUps.exhausted);
+
+    out.varint(state.schedulerNow);
+    out.varint(state.schedulerDropped);
+    out.varint(state.wheelEvents);
+    out.varint(state.heapEvents);
+    for (int i = 0; i < state.wheelEvents + state.heapEvents; i++) {
+        const SavedEvent& event = state.events[i];
+        out.signedVarint(event.due - state.schedulerNow);
+        out.byte(event.kind | (event.cancelled ? 8 : 0));
+        if (event.kind == EVENT_WAVE) {
+            out.varint(event.count);
+            out.varint(event.archetype + 1);
+            out.varint(event.interval);
+        }
+    }
+    out.varint(state.spawnEvent + 1);
+
+    writeObjects(out, state.bullets, { &from.bullets, steps, false });
+    writeObjects(out, state.enemies, { &from.enemies, -steps, true });
+    writeObjects(out, state.powerUps, { &from.powerUps, -steps, false });
+    return out.size <= capacity ? out.size : 0;
+}
+
+// Rebuild a state from encodeSnapshot() output (A delta needs the state it was made
+// against as base). False for a malformed snapshot or a missing or wrong base.
+bool decodeSnapshot(const unsigned char* data, size_t size, const SaveState* base, SaveState& state) {
+    static const SaveState empty = SaveState();
+    SnapshotReader in = { data, size };
+    if (in.byte() != 'S' || in.byte() != 'S' || in.byte() != SNAPSHOT_VERSION) return false;
+    bool delta = (in.byte() & SNAPSHOT_DELTA) != 0;
+    if (delta && (!base || base->tick < 0 || (long long)in.varint() != base->tick)) return false;
+    const SaveState& from = delta ? *base : empty;
+
+    state.tick = (long long)in.varint();
+    long long ticks = delta ? state.tick - base->tick : 0;
+    float steps = ticks * stepScale;
+    state.state = (GameState)std::min<int>(in.byte(), GAME_OVER);
+    state.currentLevel = (int)in.varint();
+    state.playerShape = (int)in.varint();
+    state.player.lives = (int)in.signedVarint();
+    state.player.score = (int)in.signedVarint();
+    state.fireCooldown = (int)in.signedVarint();
+    state.fireQueued = in.byte() != 0;
+    state.stepCarry = (int)in.varint();
+    state.rng.state = in.raw(8);
+    state.seed = delta ? base->seed : in.raw(8);
+    state.rng.increment = delta ? base->rng.increment : in.raw(8);
+    state.player.x = in.value(from.player.x);
+    state.player.y = in.value(from.player.y);
+    state.player.size = in.value(from.player.size);
+    state.player.speed = in.value(from.player.speed);
+    state.player.prevX = state.player.x;
+    state.player.prevY = state.player.y;
+    state.starOffset = in.value(from.starOffset + 0.5f * steps);
+    long long sinceSpawn = in.signedVarint();
+    long long sinceHit = in.signedVarint();
+    state.bullets.exhausted = (long long)in.varint();
+    state.enemies.exhausted = (long long)in.varint();
+    state.powerUps.exhausted = (long long)in.varint();
+
+    state.schedulerNow = (long long)in.varint();
+    state.lastSpawnTick = state.schedulerNow - sinceSpawn;
+    state.lastHitTick = state.schedulerNow - sinceHit;
+    state.schedulerDropped = (long long)in.varint();
+    uint64_t wheel = in.varint(), heap = in.varint();
+    if (in.failed || wheel + heap > (uint64_t)MAX_EVENTS) return false;
+    state.wheelEvents = (int)wheel;
+    state.heapEvents = (int)heap;
+    for (int i = 0; i < state.wheelEvents + state.heapEvents && !in.failed; i++) {
+        SavedEvent& event = state.events[i];
+        event.due = state.schedulerNow + in.signedVarint();
+        unsigned char kind = in.byte();
+        event.kind = std::min<int>(kind & 7, EVENT_KINDS - 1);
+        event.cancelled = (kind & 8) != 0;
+        event.count = 1;
+        event.archetype = -1;
+        event.interval = 0;
+        if (event.kind == EVENT_WAVE) {
+            event.count = (int)in.varint();
+            event.archetype = (int)in.varint() - 1;
+            event.interval = (int)in.varint();
+        }
+    }
+    state.spawnEvent = (int)in.varint() - 1;
+
+    return !in.failed
+        && readObjects(in, state.bullets, { &from.bullets, steps, false })
+        && readObjects(in, state.enemies, { &from.enemies, -steps, true })
+        && readObjects(in, state.powerUps, { &from.powerUps, -steps, false });
+}
+
+// Largest possible snapshot of a world with full pools (Buffer size for encodeSnapshot)
+size_t maxSnapshotSize() {
+    const size_t value = 6;   // Escaped float: tag + 4 bytes
+    const size_t varint = 10;
+    size_t objects = (size_t)(poolConfig.bullets + poolConfig.enemies + poolConfig.powerUps) * (3 * value + varint);
+    return 256 + 12 * value + (size_t)MAX_EVENTS * (5 * varint) + objects;
+}
+
+// Field by field comparison (Snapshot round trip checks)
+bool sameObjects(const SavedObjects& a, const SavedObjects& b) {
+    if (a.count != b.count || a.exhausted != b.exhausted) return false;
+    size_t n = a.count;
+    return memcmp(a.x.data(), b.x.data(), n * sizeof(float)) == 0 && memcmp(a.y.data(), b.y.data(), n * sizeof(float)) == 0
+        && memcmp(a.speed.data(), b.speed.data(), n * sizeof(float)) == 0 && std::equal(a.type.begin(), a.type.begin() + n, b.type.begin());
+}
+
+bool sameSaveState(const SaveState& a, const SaveState& b) {
+    bool same = a.tick == b.tick && a.state == b.state && a.currentLevel == b.currentLevel && a.playerShape == b.playerShape
+        && a.fireCooldown == b.fireCooldown && a.fireQueued == b.fireQueued && a.stepCarry == b.stepCarry
+        && a.rng.state == b.rng.state && a.rng.increment == b.rng.increment && a.seed == b.seed
+        && a.lastSpawnTick == b.lastSpawnTick && a.lastHitTick == b.lastHitTick
+        && a.schedulerNow == b.schedulerNow && a.schedulerDropped == b.schedulerDropped
+        && a.wheelEvents == b.wheelEvents && a.heapEvents == b.heapEvents && a.spawnEvent == b.spawnEvent
+        && a.player.lives == b.player.lives && a.player.score == b.player.score
+        && memcmp(&a.player.x, &b.player.x, sizeof(float)) == 0 && memcmp(&a.player.y, &b.player.y, sizeof(float)) == 0
+        && memcmp(&a.player.size, &b.player.size, sizeof(float)) == 0 && memcmp(&a.player.speed, &b.player.speed, sizeof(float)) == 0
+        && memcmp(&a.starOffset, &b.starOffset, sizeof(float)) == 0;
+    for (int i = 0; same && i < a.wheelEvents + a.heapEvents; i++) {
+        const SavedEvent& x = a.events[i];
+        const SavedEvent& y = b.events[i];
+        same = x.due == y.due && x.kind == y.kind && x.cancelled == y.cancelled
+            && (x.kind != EVENT_WAVE || (x.count == y.count && x.archetype == y.archetype && x.interval == y.interval));
+    }
+    return same && sameObjects(a.bullets, b.bullets) && sameObjects(a.enemies, b.enemies) && sameObjects(a.powerUps, b.powerUps);
+}
+
+// === SIMULATION THREAD ===
+// update() runs on its own thread at the fixed tick rate and publishes a
+// snapshot after each batch of ticks. The GLUT thread only renders snapshots,
+// so a slow GL driver no longer holds back the game logic.
+std::chrono::steady_clock::duration tickDuration() {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(tickSeconds));
+}
+
+std::chrono::steady_clock::time_point simClock; // When the last tick was due
+std::atomic<bool> simRunning(false);
+std::thread simThread;
+bool singleThreaded = false; // --single-thread: tick from the GLUT idle callback instead
+
+// Turn a tick's intent into its command (SPACE outside PLAYING starts the game)
+TickCommand World::tickCommand(const InputIntent& intent) const {
+    TickCommand command;
+    command.move = intent.bits & (INTENT_LEFT | INTENT_RIGHT | INTENT_UP | INTENT_DOWN);
+    command.presses = intent.presses;
+    command.fireHeld = !legacyFire && (intent.bits & INTENT_FIRE);
+    if (command.presses > 0 && gameState != PLAYING) {
+        command.start = true;
+        command.presses--;
+    }
+    return command;
+}
+
+// New session in MENU: the seed alone decides everything that follows
+void World::reset(uint64_t seed) {
+    this->seed = seed;
+    seedRandom(rng, seed);
+    resetGame();
+    gameState = MENU;
+    tick = 0;
+}
+
+// Advance the world by one tick of input
+void World::step(const InputIntent& intent) {
+    TickCommand command = tickCommand(intent);
+    if (command.start) {
+        gameState = PLAYING;
+        // Reset all game variables for restart
+        resetGame();
+    }
+    update(command);
+    tick++;
+}
+
+// One tick of the window's world with the given input: record it, then advance the game
+// (Shared by the simulation thread, headless runs and replay playback)
+void stepTick(const InputIntent& intent) {
+    replayRecordTick(world.tick, intent.bits, intent.presses);
+    world.step(intent);
+}
+
+// One tick with the input queued since the last one
+void stepTick() {
+    stepTick(drainInput());
+}
+
+// Quick save (F8) and load (F9): asked for by the GLUT thread, done by the simulation
+// thread between two ticks. The save is kept as an encoded snapshot.
+enum SaveRequest { SAVE_NONE, SAVE_STORE, SAVE_RESTORE };
+std::atomic<int> saveRequest(SAVE_NONE);
+SaveState quickState;
+std::vector<unsigned char> quickSave; // maxSnapshotSize() bytes (Reserved by allocateWindowBuffers)
+size_t quickSaveSize = 0;
+
+// Returns true when the world was loaded (Its new state must be published)
+bool serveSaveRequest() {
+    int request = saveRequest.exchange(SAVE_NONE);
+    if (request == SAVE_STORE) {
+        world.save(quickState);
+        quickSaveSize = encodeSnapshot(quickState, NULL, quickSave.data(), quickSave.size());
+    }
+    // Not while recording: a replay only holds input, so it could not play a load back
+    else if (request == SAVE_RESTORE && quickSaveSize > 0 && !recorder.file
+        && decodeSnapshot(quickSave.data(), quickSaveSize, NULL, quickState)) {
+        world.load(quickState);
+        return true;
+    }
+    return false;
+}
+
+// Run every tick that is due by now (Pending input first), then publish the result
+void runDueTicks(std::chrono::steady_clock::time_point now) {
+    const std::chrono::steady_clock::duration step = tickDuration();
+    bool loaded = serveSaveRequest();
+    int ticks = 0;
+    while (now - simClock >= step && ticks < MAX_TICKS_PER_FRAME) {
+        simClock += step;
+        stepTick();
+        pushEffects(world);
+        ticks++;
+    }
+    if (ticks == MAX_TICKS_PER_FRAME && now - simClock >= step) {
+        // Too far behind: drop the backlog instead of spiralling
+        simClock = now;
+    }
+    if (ticks > 0 || loaded) {
+        publishSnapshot(simClock);
+    }
+}
+
+void simulationThread() {
+    while (simRunning.load(std::memory_order_relaxed)) {
+        runDueTicks(std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(simClock + tickDuration());
+    }
+}
+
+// Registered with atexit: GLUT leaves through exit(), the thread must be joined first
+void stopSimulation() {
+    if (simRunning.exchange(false)) {
+        simThread.join();
+    }
+}
+
+void startSimulation() {
+    simClock = std::chrono::steady_clock::now();
+    publishSnapshot(simClock);
+    if (singleThreaded) return;
+
+    simRunning = true;
+    simThread = std::thread(simulationThread);
+    atexit(stopSimulation);
+}
+
+// Main loop (GLUT idle callback): keep rendering, and tick here in single-threaded mode
+void gameLoop() {
+    if (singleThreaded) {
+        runDueTicks(std::chrono::steady_clock::now());
+    }
+    const GameSnapshot& frame = latestSnapshot();
+    if (idle.enabled && frame.state != PLAYING) {
+        idle.pending = idleDamage(idleView(frame));
+        if (idle.pending == DAMAGE_NONE) {
+            idle.pending = DAMAGE_FULL;
+            // Queued keys not in a snapshot yet may still change the screen (SPACE starts
+            // the game): keep polling until the simulation has applied them
+            if (frame.inputApplied != inputQueue.head.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+                return;
+            }
+            idleSleep();
+            return;
+        }
+    }
+    pacingWait();
+    glutPostRedisplay();
+}
+
+// Display function (Renders everything)
+void display() {
+    static std::chrono::steady_clock::time_point lastDisplay = std::chrono::steady_clock::now();
+    auto now = std::chrono::steady_clock::now();
+    profileRecord(PROFILE_FRAME, std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastDisplay).count());
+    MemoryTagScope tag(MEMORY_RENDER);
+    memorySampleFrame();
+    // Particles move by real time (At most a tenth of a second after a stall)
+    float frameSeconds = std::min(0.1f, (float)std::chrono::duration<double>(now - lastDisplay).count());
+    lastDisplay = now;
+
+    if (!font.ready && !font.failed) {
+        buildFontAtlas();
+    }
+    arenaReset(frameArena);
+    rasterFrameBegin();
+    renderTargetBegin();
+
+    // Newest simulation state, and how far we are into the tick after it
+    const GameSnapshot& frame = latestSnapshot();
+    static GameState lastState = MENU;
+    NoAllocationScope steady(frame.state == PLAYING && lastState == PLAYING);
+    lastState = frame.state;
+    float alpha = (float)(std::chrono::duration<double>(now - frame.tickTime).count() / tickSeconds);
+    alpha = std::max(0.0f, std::min(1.0f, alpha));
+
+    // MENU/GAME_OVER: a full redraw, or only the overlay over the cached static layer
+    bool idleScreen = idle.enabled && frame.state != PLAYING;
+    IdleDamage damage = idleScreen ? idle.pending : DAMAGE_FULL;
+    idle.pending = DAMAGE_FULL;
+
+    gpuTimerBegin();
+    {
+        ProfileScope renderScope(PROFILE_RENDER);
+        if (damage == DAMAGE_OVERLAY) {
+            idleCacheRestore();
+            idle.restores++;
+        }
+        else {
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // Interpolated star scroll (No blending across the wrap-around)
+            float stars = frame.starOffset >= frame.prevStarOffset ? lerp(frame.prevStarOffset, frame.starOffset, alpha) : frame.starOffset;
+            {
+                ProfileScope scope(PROFILE_STARS);
+                drawStars(stars); // Draw background first
+            }
+        }
+
+        if (damage == DAMAGE_OVERLAY) {
+            // Static layer already restored
+        }
+        else if (frame.state == MENU) {
+            drawMenu();
+        }
+        else if (frame.state == PLAYING) {
+            {
+                ProfileScope scope(PROFILE_PLAYER);
+                const Player& ship = frame.player;
+                drawPlayer(ship, lerp(ship.prevX, ship.x, alpha), lerp(ship.prevY, ship.y, alpha));
+            }
+
+            // Animation values are shared by every enemy/power-up this frame
+            float elapsed = glutGet(GLUT_ELAPSED_TIME);
+            float rotation = elapsed * 0.1;
+            float pulse = 1.0 + 0.2 * sin(elapsed * 0.01);
+            DetailLevel level = lodUpdate(frame.enemies.count + frame.powerUps.count);
+            instanced.level = level;
+
+            batchBegin();
+
+            // Draw active bullets
+            {
+                ProfileScope scope(PROFILE_BULLETS);
+                batchLayer(LAYER_BULLETS);
+                const ObjectView& bullets = frame.bullets;
+                for (int i = 0; i < bullets.count; i++) {
+                    drawBullet(bullets.x[i], lerp(bullets.prevY[i], bullets.y[i], alpha), frame.level);
+                }
+            }
+
+            // Draw active enemies
+            {
+                ProfileScope scope(PROFILE_ENEMIES);
+                batchLayer(LAYER_ENEMIES);
+                if (instancedOn()) instancedEnemies(frame.enemies, alpha);
+                else drawEnemies(frame.enemies, alpha, rotation, level);
+            }
+
+            // Draw active power-ups
+            {
+                ProfileScope scope(PROFILE_POWERUPS);
+                batchLayer(LAYER_POWERUPS);
+                const ObjectView& powerUps = frame.powerUps;
+                for (int i = 0; i < powerUps.count; i++) {
+                    float y = lerp(powerUps.prevY[i], powerUps.y[i], alpha);
+                    if (instancedOn()) instancedPowerUp(powerUps.x[i], y);
+                    else drawPowerUp(powerUps.x[i], y, pulse, level);
+                }
+            }
+
+            {
+                ProfileScope scope(PROFILE_FLUSH);
+                batchFlush();
+                if (instancedOn()) instancedFlush(elapsed);
+            }
+
+            {
+                ProfileScope scope(PROFILE_PARTICLES);
+                particlesFrame(frameSeconds);
+            }
+
+            {
+                ProfileScope scope(PROFILE_HUD);
+                drawHUD(frame); // Draw HUD last so it's on top
+            }
+        }
+        else if (frame.state == GAME_OVER) {
+            drawGameOver(frame);
+        }
+        if (frame.state != PLAYING) {
+            clearParticles();
+        }
+
+        if (idleScreen) {
+            if (damage == DAMAGE_FULL) idleCacheStore();
+            idle.shown = idleView(frame);
+            idle.frames++;
+        }
+        else {
+            idle.shown = IdleView();
+        }
+
+        if (showProfiler) {
+            drawProfiler(frame);
+        }
+        renderTargetEnd();
+    }
+    gpuTimerEnd();
+
+    glutSwapBuffers();
+    pacingAfterSwap(frame.inputTime);
+}
+
+// Window resized: refit the viewport, keep the projection in playfield units
+void reshape(int width, int height) {
+    MemoryTagScope tag(MEMORY_RENDER);
+    renderTargetResize(width, height);
+    glViewport(renderTarget.viewX, renderTarget.viewY, renderTarget.viewWidth, renderTarget.viewHeight);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(0, playfield.width, 0, playfield.height);
+    glMatrixMode(GL_MODELVIEW);
+
+    // The cached static layer has the old size
+    idle.cached = false;
+    idle.shown = IdleView();
+    idleWake();
+    glutPostRedisplay();
+}
+
+// Keyboard input handlers (Only queue events, the simulation thread applies them)
+// Letters are matched case-insensitively, so Shift does not leave a key stuck.
+void pushLetter(unsigned char key, bool down) {
+    switch (tolower(key)) {
+    case 'a': pushInput(KEY_A, down); break;
+    case 'd': pushInput(KEY_D, down); break;
+    case 'w': pushInput(KEY_W, down); break;
+    case 's': pushInput(KEY_S, down); break;
+    case ' ': pushInput(KEY_SPACE, down); break;
+    }
+}
+
+void keyboardDown(unsigned char key, int x, int y) {
+    idleWake();
+    if (key == 27) { // ESC
+        exit(0);
+    }
+    pushLetter(key, true);
+}
+
+void keyboardUp(unsigned char key, int x, int y) {
+    idleWake();
+    pushLetter(key, false);
+}
+
+// Special keyboard functions (For Arrow Keys)
+void specialDown(int key, int x, int y) {
+    idleWake();
+    switch (key) {
+    case GLUT_KEY_LEFT:
+        pushInput(KEY_LEFT, true);
+        break;
+    case GLUT_KEY_RIGHT:
+        pushInput(KEY_RIGHT, true);
+        break;
+    case GLUT_KEY_UP:
+        pushInput(KEY_UP, true);
+        break;
+    case GLUT_KEY_DOWN:
+        pushInput(KEY_DOWN, true);
+        break;
+    case GLUT_KEY_F3:
+        showProfiler = !showProfiler;
+        break;
+    case GLUT_KEY_F4:
+        rasterMode = rasterMode == RASTER_GPU ? RASTER_CPU : RASTER_GPU;
+        break;
+    case GLUT_KEY_F5:
+        instanced.enabled = !instanced.enabled;
+        break;
+    case GLUT_KEY_F6:
+        pacer.mode = (PacingMode)((pacer.mode + 1) % PACE_MODE_COUNT);
+        applyPacing();
+        break;
+    case GLUT_KEY_F7:
+        // auto -> full -> reduced -> solid -> sprite -> auto
+        if (lod.automatic) {
+            lod.automatic = false;
+            lod.level = LOD_FULL;
+        }
+        else if (lod.level == LOD_SPRITE) {
+            lod.automatic = true;
+        }
+        else {
+            lod.level = (DetailLevel)(lod.level + 1);
+        }
+        break;
+    case GLUT_KEY_F8:
+        saveRequest = SAVE_STORE;
+        break;
+    case GLUT_KEY_F9:
+        saveRequest = SAVE_RESTORE;
+        break;
+    }
+}
+
+void specialUp(int key, int x, int y) {
+    idleWake();
+    switch (key) {
+    case GLUT_KEY_LEFT:
+        pushInput(KEY_LEFT, false);
+        break;
+    case GLUT_KEY_RIGHT:
+        pushInput(KEY_RIGHT, false);
+        break;
+    case GLUT_KEY_UP:
+        pushInput(KEY_UP, false);
+        break;
+    case GLUT_KEY_DOWN:
+        pushInput(KEY_DOWN, false);
+        break;
+    }
+}
+
+// Allocate the pools of a world and the structures sized from them (Once, before it runs)
+void World::allocate() {
+    MemoryTagScope tag(MEMORY_ENTITIES);
+    tickArena.tag = MEMORY_ENTITIES;
+    entityReserve(bullets, poolConfig.bullets);
+    entityReserve(enemies, poolConfig.enemies);
+    entityReserve(powerUps, poolConfig.powerUps);
+    gridReserve(enemyGrid, poolConfig.enemies);
+    scheduler.later.reserve(MAX_EVENTS);
+    arenaReserve(tickArena, (poolConfig.bullets + MAX_JOB_CHUNKS * 16) * sizeof(HitPair) + 4096);
+    for (ArenaArray<HitPair>& found : hitPairs) found.arena = &tickArena;
+    effects.arena = &tickArena;
 }
 
-// Midpoint Circle Algorithm (Used for Ship Cockpit and Enemy Outlines)
-void drawCircleMidpoint(float cx, float cy, float r) {
-    int x = 0;
-    int y = r;
-    int d = 1 - r;
+// Allocate every object pool and the structures sized from them (Once, before the game starts)
+void allocatePools() {
+    world.allocate();
+    world.profiled = true;
+}
 
-    glBegin(GL_POINTS);
+// The render side of the pools: frame arena, snapshots and the quick save (Only for a
+// window, so headless, replay and world runs do not report render or replay memory)
+void allocateWindowBuffers() {
+    MemoryTagScope tag(MEMORY_RENDER);
+    frameArena.tag = MEMORY_RENDER;
+    arenaReserve(frameArena, (poolConfig.bullets * 12 + poolConfig.enemies * 64 + poolConfig.powerUps * 100) * sizeof(BatchVertex));
+    for (GameSnapshot& snapshot : snapshots.slots) {
+        reserveSnapshot(snapshot);
+    }
+    MemoryTagScope saves(MEMORY_REPLAY);
+    reserveSaveState(quickState);
+    quickSave.assign(maxSnapshotSize(), 0);
+}
 
-    auto plotCirclePoints = [&](int x, int y) {
-        glVertex2f(cx + x, cy + y);
-        glVertex2f(cx - x, cy + y);
-        glVertex2f(cx + x, cy - y);
-        glVertex2f(cx - x, cy - y);
-        glVertex2f(cx + y, cy + x);
-        glVertex2f(cx - y, cy + x);
-        glVertex2f(cx + y, cy - x);
-        glVertex2f(cx - y, cy - x);
-        };
+// === HEADLESS BENCHMARK ===
+// Runs update() without a window or any GL calls, driven by a scripted player.
+// The same seed and settings always produce the same game (See the checksum).
+// --worlds=N runs the same script in up to N worlds at once, one thread each.
+struct BenchConfig {
+    long long ticks = 100000;
+    uint64_t seed = 1;
+    int fireEvery = 10; // Ticks between shots, 0 = never shoot
+    const char* memoryStats = NULL; // --memory-stats=FILE
+    int memoryEvery = 1000;         // --memory-every: ticks between two memory samples
+};
 
-    while (x <= y) {
-        plotCirclePoints(x, y);
-        x++;
-        if (d < 0) {
-            d += 2 * x + 1;
-        }
-        else {
-            y--;
-            d += 2 * (x - y) + 1;
-        }
+// --memory-stats=FILE: the memory counters of every tag, sampled every memoryEvery ticks
+// of a headless run. JSON when FILE ends in .json, CSV otherwise. Allocation counts are
+// since the run started; per_tick is the rate since the previous sample.
+struct MemoryDump {
+    FILE* file = NULL;
+    bool json = false;
+    long long samples = 0;
+    long long lastTick = 0;
+    long long start[MEMORY_TAG_COUNT] = {};
+    long long seen[MEMORY_TAG_COUNT] = {};
+};
+
+bool memoryDumpOpen(MemoryDump& dump, const BenchConfig& config) {
+    if (!config.memoryStats) return true;
+    dump.file = fopen(config.memoryStats, "w");
+    if (!dump.file) {
+        fprintf(stderr, "Cannot write memory stats to %s\n", config.memoryStats);
+        return false;
     }
-    glEnd();
+    size_t length = strlen(config.memoryStats);
+    dump.json = length >= 5 && strcmp(config.memoryStats + length - 5, ".json") == 0;
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        dump.start[tag] = dump.seen[tag] = memoryCounters[tag].allocations.load(std::memory_order_relaxed);
+    }
+    if (dump.json) fprintf(dump.file, "{\"seed\": %llu, \"tick_rate\": %d, \"every\": %d, \"samples\": [",
+        (unsigned long long)config.seed, tickRate, config.memoryEvery);
+    else fprintf(dump.file, "tick,tag,live_bytes,peak_bytes,allocations,allocations_per_tick\n");
+    return true;
 }
 
-// Filled circle (Used for Life Icons, Power-ups, and Circular Enemy Body)
-void drawFilledCircle(float cx, float cy, float r) {
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(cx, cy);
-    for (int i = 0; i <= 360; i++) {
-        float angle = i * 3.14159 / 180;
-        glVertex2f(cx + r * cos(angle), cy + r * sin(angle));
+void memoryDumpSample(MemoryDump& dump, long long tick) {
+    if (!dump.file || tick == dump.lastTick) return;
+    double ticks = (double)(tick - dump.lastTick);
+    if (dump.json) fprintf(dump.file, "%s\n  {\"tick\": %lld", dump.samples > 0 ? "," : "", tick);
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        const MemoryCounters& counters = memoryCounters[tag];
+        long long live = counters.live.load(std::memory_order_relaxed);
+        long long peak = counters.peak.load(std::memory_order_relaxed);
+        long long allocations = counters.allocations.load(std::memory_order_relaxed);
+        double perTick = (allocations - dump.seen[tag]) / ticks;
+        if (dump.json) fprintf(dump.file, ", \"%s\": {\"live\": %lld, \"peak\": %lld, \"allocations\": %lld, \"per_tick\": %.4f}",
+            memoryTagNames[tag], live, peak, allocations - dump.start[tag], perTick);
+        else fprintf(dump.file, "%lld,%s,%lld,%lld,%lld,%.4f\n", tick, memoryTagNames[tag], live, peak, allocations - dump.start[tag], perTick);
+        dump.seen[tag] = allocations;
     }
-    glEnd();
+    if (dump.json) fprintf(dump.file, "}");
+    dump.lastTick = tick;
+    dump.samples++;
 }
 
-// Draw text (Used for HUD and Menu Screens)
-void drawText(float x, float y, const char* text) {
-    glRasterPos2f(x, y);
-    for (const char* c = text; *c != '\0'; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
-    }
+void memoryDumpClose(MemoryDump& dump) {
+    if (!dump.file) return;
+    if (dump.json) fprintf(dump.file, "\n]}\n");
+    fclose(dump.file);
+    dump.file = NULL;
 }
 
-// Draw stars (Background scrolling effect)
-void drawStars() {
-    glColor3f(1.0, 1.0, 1.0);
-    glPointSize(2.0);
+// First multiple of period in the game ticks [from, to), or -1
+long long multipleIn(long long from, long long to, int period) {
+    long long multiple = (from + period - 1) / period * period;
+    return multiple < to ? multiple : -1;
+}
 
-    for (int i = 0; i < 100; i++) {
-        float x = (i * 73) % WIDTH;
-        // Use starOffset for scrolling and fmod for looping
-        float y = fmod((i * 117 + starOffset), HEIGHT);
-        glBegin(GL_POINTS);
-        glVertex2f(x, y);
-        glEnd();
+// Scripted player of one world: sweep left and right across the screen, shooting at a
+// fixed rate, and press SPACE to start and after every game over. It produces the intent
+// the keyboard path would fold from the same key events (Tapped SPACE: a press, not held),
+// so headless runs can be recorded and every world can have its own player.
+// The script runs on game ticks, so it plays the same at any --tick-rate.
+struct BenchPlayer {
+    unsigned char move = 0; // Direction held since the last turn
+    int starts = 1;         // SPACE presses to add to the next step (The first starts the game)
+};
+
+InputIntent benchInput(BenchPlayer& script, long long tick, const BenchConfig& config) {
+    long long from = (tick * GAME_TICK_RATE + tickRate - 1) / tickRate; // Game ticks of this step
+    long long to = ((tick + 1) * GAME_TICK_RATE + tickRate - 1) / tickRate;
+    long long turn = multipleIn(from, to, 120);
+    if (turn >= 0) {
+        script.move = (turn / 120) % 2 == 0 ? INTENT_RIGHT : INTENT_LEFT;
+    }
+    InputIntent intent;
+    intent.bits = script.move;
+    intent.presses = script.starts;
+    script.starts = 0;
+    if (config.fireEvery > 0 && multipleIn(from, to, config.fireEvery) >= 0) {
+        intent.presses++;
     }
-    glPointSize(1.0);
+    return intent;
 }
 
-// Draw player spaceship (Triangle Ship with wobble animation)
-void drawPlayer() {
-    glPushMatrix();
+// FNV-1a over the parts of the state a different code path would most likely change
+uint64_t stateChecksum(const World& world) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&](const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        };
+    mix(&world.player.x, sizeof(world.player.x));
+    mix(&world.player.y, sizeof(world.player.y));
+    mix(&world.player.lives, sizeof(world.player.lives));
+    mix(&world.player.score, sizeof(world.player.score));
+    mix(&world.currentLevel, sizeof(world.currentLevel));
+    mix(&world.bullets.count, sizeof(world.bullets.count));
+    mix(&world.enemies.count, sizeof(world.enemies.count));
+    mix(&world.powerUps.count, sizeof(world.powerUps.count));
+    return hash;
+}
 
-    // 1. Translation: Move drawing origin to player's center (player.x, player.y)
-    glTranslatef(player.x, player.y, 0);
+int runHeadless(const BenchConfig& config, const char* recordPath) {
+    world.reset(config.seed);
+    if (recordPath && !replayStartRecording(recordPath, world.seed)) return 1;
+    MemoryDump dump;
+    if (!memoryDumpOpen(dump, config)) return 1;
 
-    // 2. Rotation effect (wobble)
-    float wobble = sin(glutGet(GLUT_ELAPSED_TIME) * 0.005) * 2;
-    glRotatef(wobble, 0, 0, 1);
+    BenchPlayer script; // Starts the game with SPACE, like a player would
+    long long restarts = 0;
+    long long entityTicks = 0;
+    int peakBullets = 0, peakEnemies = 0, peakPowerUps = 0;
 
-    glLineWidth(3.0);
+    long long allocationsBefore = allocationCount;
+    auto start = std::chrono::steady_clock::now();
 
-    // --- Determine Ship Color (Red Alert on 1 Life) ---
-    if (player.lives == 1) {
-        glColor3f(1.0, 0.0, 0.0); // CRITICAL: Red
+    for (long long tick = 0; tick < config.ticks; tick++) {
+        stepTick(benchInput(script, tick, config));
+
+        entityTicks += world.bullets.count + world.enemies.count + world.powerUps.count;
+        peakBullets = std::max(peakBullets, world.bullets.count);
+        peakEnemies = std::max(peakEnemies, world.enemies.count);
+        peakPowerUps = std::max(peakPowerUps, world.powerUps.count);
+
+        if (world.gameState == GAME_OVER) {
+            restarts++;
+            script.starts++;
+        }
+        if ((tick + 1) % config.memoryEvery == 0) memoryDumpSample(dump, tick + 1);
     }
-    else {
-        glColor3f(0.0, 0.8, 1.0); // Default Blue color
+    replayStopRecording(world.tick);
+    memoryDumpSample(dump, config.ticks);
+    memoryDumpClose(dump);
+
+    auto end = std::chrono::steady_clock::now();
+    long long allocations = allocationCount - allocationsBefore;
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    printf("Space Defender headless benchmark\n");
+    printf("  seed %llu, %lld ticks at %d Hz, spawn rate %d, burst %d, fire every %d, kernels %s, %d job threads\n",
+        (unsigned long long)config.seed, config.ticks, tickRate, forcedSpawnRate, spawnBurst, config.fireEvery, simd.name, jobs.threads);
+    printf("  time:        %.1f ms total, %.1f ns/tick\n", seconds * 1000, seconds * 1e9 / std::max(1LL, config.ticks));
+    printf("  entities:    %.1f mean live, peak %d bullets / %d enemies / %d power-ups\n",
+        (double)entityTicks / std::max(1LL, config.ticks), peakBullets, peakEnemies, peakPowerUps);
+    printf("  allocations: %lld (%.3f per tick)\n", allocations, (double)allocations / std::max(1LL, config.ticks));
+    printf("  pool misses: %lld bullets / %lld enemies / %lld power-ups\n",
+        world.bullets.exhausted, world.enemies.exhausted, world.powerUps.exhausted);
+    printf("  tick arena:  %.1f KB peak of %.1f KB, grown %lld times\n",
+        world.tickArena.peak / 1024.0, world.tickArena.capacity / 1024.0, world.tickArena.grows);
+    printf("  memory:     ");
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        printf(" %s %.1f KB%s", memoryTagNames[tag], memoryCounters[tag].peak.load(std::memory_order_relaxed) / 1024.0,
+            tag + 1 < MEMORY_TAG_COUNT ? "," : " peak\n");
     }
+    printf("  restarts:    %lld, checksum %016llx\n", restarts, (unsigned long long)stateChecksum(world));
+    if (recordPath) printf("  recorded:    %s\n", recordPath);
+    if (config.memoryStats) printf("  memory log:  %s, %lld samples\n", config.memoryStats, dump.samples);
+    return 0;
+}
 
-    // --- Draw Triangle Ship ---
-    glBegin(GL_TRIANGLES);
-    glVertex2f(0, player.size); // Top point
-    glVertex2f(-player.size / 2, -player.size / 2); // Bottom-left
-    glVertex2f(player.size / 2, -player.size / 2); // Bottom-right
-    glEnd();
+// One world of the world benchmark: its own state, player script and result
+struct BenchWorld {
+    World world;
+    uint64_t checksum = 0;
+    long long restarts = 0;
+};
 
-    // Cockpit 
-    glColor3f(0.3, 0.9, 1.0);
-    drawCircleMidpoint(0, player.size / 3, player.size / 4);
-    // Extra cockpits for style
-    drawCircleMidpoint(10, player.size / 3, player.size / 4);
-    drawCircleMidpoint(-10, player.size / 3, player.size / 4);
-    drawCircleMidpoint(0, -player.size, player.size / 4);
+void playBenchWorld(BenchWorld& bench, const BenchConfig& config) {
+    World& world = bench.world;
+    BenchPlayer script;
+    world.reset(config.seed);
+    bench.restarts = 0;
+    for (long long tick = 0; tick < config.ticks; tick++) {
+        world.step(benchInput(script, tick, config));
+        if (world.gameState == GAME_OVER) {
+            bench.restarts++;
+            script.starts++;
+        }
+    }
+    bench.checksum = stateChecksum(world);
+}
 
+// Step 1, 2, 4 ... count worlds concurrently, one thread each, and report world-ticks per
+// second. Every world plays the same seed and script, so each must end with the checksum
+// of the single world; a different one means worlds leaked state into each other.
+// Job workers are not started: the worlds already occupy the cores, sweeps run inline.
+int runWorlds(const BenchConfig& config, int count) {
+    std::vector<BenchWorld> benches(count);
+    for (BenchWorld& bench : benches) bench.world.allocate();
 
-    // Wings (Drawn using Bresenham's algorithm)
-    glColor3f(0.0, 0.6, 0.8);
-    drawLineBresenham(-player.size / 2, -player.size / 2, -player.size, -player.size);
-    drawLineBresenham(player.size / 2, -player.size / 2, player.size, -player.size);
+    printf("Space Defender world benchmark\n");
+    printf("  seed %llu, %lld ticks per world at %d Hz, spawn rate %d, burst %d, fire every %d, kernels %s, %u cores\n",
+        (unsigned long long)config.seed, config.ticks, tickRate, forcedSpawnRate, spawnBurst, config.fireEvery, simd.name,
+        std::thread::hardware_concurrency());
+    printf("  worlds   world-ticks/s   per world      scaling\n");
 
-    glLineWidth(1.0);
+    uint64_t expected = 0;
+    int mismatches = 0;
+    double single = 0;
+    for (int worlds = 1; worlds <= count; worlds = worlds == count ? count + 1 : std::min(count, worlds * 2)) {
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (int k = 0; k < worlds; k++) {
+            threads.emplace_back([&, k] {
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                playBenchWorld(benches[k], config);
+                });
+        }
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (std::thread& thread : threads) thread.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-    glPopMatrix();
+        if (worlds == 1) expected = benches[0].checksum;
+        for (int k = 0; k < worlds; k++) {
+            if (benches[k].checksum != expected) mismatches++;
+        }
+        double rate = worlds * config.ticks / std::max(seconds, 1e-9);
+        if (worlds == 1) single = rate;
+        printf("  %6d   %13.0f   %9.0f   %9.2fx\n", worlds, rate, rate / worlds, rate / std::max(single, 1e-9));
+    }
+    printf("  restarts:    %lld per world, checksum %016llx\n", benches[0].restarts, (unsigned long long)expected);
+    printf("  determinism: %s\n", mismatches == 0 ? "every world matches the single world" : "MISMATCH");
+    return mismatches == 0 ? 0 : 1;
 }
 
-// Draw bullet (Conditional appearance based on level)
-void drawBullet(float x, float y) {
+// Snapshot round trip of a headless run (--snapshot-check). Every tick the world is saved,
+// encoded whole and as a delta against the tick before, and both are decoded (The delta
+// against the previously decoded state, like a receiver would) and compared with the
+// original. Halfway through a second world is loaded from the decoded state; from then
+// on both get the same input and must stay identical.
+int runSnapshotCheck(const BenchConfig& config) {
+    std::vector<BenchWorld> benches(2);
+    World& original = benches[0].world;
+    World& restored = benches[1].world;
+    original.allocate();
+    restored.allocate();
+    std::vector<SaveState> states(5);
+    for (SaveState& state : states) reserveSaveState(state);
+    SaveState* current = &states[0];
+    SaveState* previous = &states[1];
+    SaveState* received = &states[2];
+    SaveState* receivedBefore = &states[3];
+    SaveState& whole = states[4];
+    std::vector<unsigned char> fullBuffer(maxSnapshotSize()), deltaBuffer(maxSnapshotSize());
+    std::vector<uint32_t> deltaSizes(std::max(1LL, config.ticks));
 
-    // --- Determine Bullet Appearance based on Level ---
-    if (currentLevel < 3) {
-        // Level 1 or 2: Yellow (Original)
-        glColor3f(1.0, 1.0, 0.0); // Yellow color
-        glBegin(GL_QUADS);
+    BenchPlayer script;
+    original.reset(config.seed);
+    long long restoreTick = config.ticks / 2, diverged = -1, mismatches = 0;
+    size_t fullTotal = 0, fullPeak = 0, deltaTotal = 0;
+    std::chrono::steady_clock::duration saving{}, encoding{}, decoding{};
+    long long allocationsBefore = allocationCount;
 
-        // Size: 4 units wide, 10 units tall
-        glVertex2f(x - 2, y - 5);
-        glVertex2f(x + 2, y - 5);
-        glVertex2f(x + 2, y + 5);
-        glVertex2f(x - 2, y + 5);
+    for (long long tick = 0; tick < config.ticks; tick++) {
+        InputIntent intent = benchInput(script, tick, config);
+        original.step(intent);
+        if (original.gameState == GAME_OVER) script.starts++;
+        if (tick > restoreTick) {
+            restored.step(intent);
+            if (diverged < 0 && stateChecksum(original) != stateChecksum(restored)) diverged = tick;
+        }
 
-        glEnd();
-    }
-    else {
-        // Level 3 or higher: Red (Power-up look for final level)
-        glColor3f(1.0, 0.0, 0.0); // Red color
-        glBegin(GL_QUADS);
+        NoAllocationScope steady(true);
+        auto t0 = std::chrono::steady_clock::now();
+        original.save(*current);
+        auto t1 = std::chrono::steady_clock::now();
+        size_t delta = encodeSnapshot(*current, previous, deltaBuffer.data(), deltaBuffer.size());
+        auto t2 = std::chrono::steady_clock::now();
+        bool valid = decodeSnapshot(deltaBuffer.data(), delta, receivedBefore, *received);
+        auto t3 = std::chrono::steady_clock::now();
+        saving += t1 - t0;
+        encoding += t2 - t1;
+        decoding += t3 - t2;
 
-        // Size: 6 units wide, 14 units tall
-        glVertex2f(x - 3, y - 0);
-        glVertex2f(x + 3, y - 1);
-        glVertex2f(x, y + 7);
-        glVertex2f(x - 3, y + 7);
+        size_t full = encodeSnapshot(*current, NULL, fullBuffer.data(), fullBuffer.size());
+        valid = valid && decodeSnapshot(fullBuffer.data(), full, NULL, whole) && sameSaveState(whole, *current);
+        if (!valid || !sameSaveState(*received, *current)) mismatches++;
+        if (tick == restoreTick) restored.load(*received);
 
-        glEnd();
+        fullTotal += full;
+        fullPeak = std::max(fullPeak, full);
+        deltaTotal += delta;
+        deltaSizes[tick] = (uint32_t)delta;
+        std::swap(current, previous);
+        std::swap(received, receivedBefore);
     }
-}
+    long long allocations = allocationCount - allocationsBefore;
 
-// Draw enemy with different types (Circle, Triangle, Square, and DDA Line Enemy)
-void drawEnemy(Enemy& enemy) {
-    glPushMatrix();
-    glTranslatef(enemy.x, enemy.y, 0);
+    long long ticks = std::max(1LL, config.ticks);
+    std::sort(deltaSizes.begin(), deltaSizes.end());
+    auto perTick = [&](std::chrono::steady_clock::duration time) {
+        return std::chrono::duration<double, std::nano>(time).count() / ticks;
+        };
+    printf("Space Defender snapshot check\n");
+    printf("  seed %llu, %lld ticks at %d Hz, spawn rate %d, burst %d, fire every %d, format version %d\n",
+        (unsigned long long)config.seed, config.ticks, tickRate, forcedSpawnRate, spawnBurst, config.fireEvery, SNAPSHOT_VERSION);
+    printf("  full:        %.1f bytes mean, %zu peak\n", (double)fullTotal / ticks, fullPeak);
+    printf("  delta:       %.1f bytes mean, %u p99, %u peak\n", (double)deltaTotal / ticks,
+        deltaSizes[std::min<size_t>(deltaSizes.size() - 1, deltaSizes.size() * 99 / 100)], deltaSizes.back());
+    printf("  time:        save %.0f ns, encode %.0f ns, decode %.0f ns per tick (Delta)\n",
+        perTick(saving), perTick(encoding), perTick(decoding));
+    printf("  allocations: %lld\n", allocations);
+    printf("  round trip:  %lld of %lld ticks differ\n", mismatches, config.ticks);
+    if (diverged >= 0) printf("  restore:     diverged at tick %lld\n", diverged);
+    else printf("  restore:     loaded at tick %lld, identical for the remaining %lld ticks\n",
+        restoreTick, std::max(0LL, config.ticks - restoreTick - 1));
+    return mismatches == 0 && diverged < 0 ? 0 : 1;
+}
 
-    // Rotation animation
-    float rotation = glutGet(GLUT_ELAPSED_TIME) * 0.1;
-    glRotatef(rotation, 0, 0, 1);
+// Particle cost without a window (--particle-bench=N). Keeps about N particles alive for
+// 1000 frames at 60 fps: every frame emits the same number that die. A frame's time covers
+// emitting, moving and copying the live range into a staging buffer laid out like the
+// vertex buffer (What the driver would have to take in), not the GPU work.
+int runParticleBench(int target) {
+    const int FRAMES = 1000;
+    const float dt = 1.0f / 60;
+    particles.capacity = std::max(particles.capacity, target);
+    reserveParticles();
+    EffectStyle style = { std::max(1, (int)(target * dt)), 30, 220, 1.0f, 1.0f, { 1, 0.6f, 0.2f } };
+    std::vector<unsigned char> staging((size_t)particles.capacity * (12 + 4));
 
-    if (enemy.type == 0) { // Circle enemy
-        glColor3f(1.0, 0.0, 0.0);
-        drawFilledCircle(0, 0, 15);
-        glColor3f(0.5, 0.0, 0.0);
-        drawCircleMidpoint(0, 0, 15);
-    }
-    else if (enemy.type == 1) { // Triangle enemy
-        glColor3f(1.0, 0.3, 0.0);
-        glBegin(GL_TRIANGLES);
-        glVertex2f(0, -20);
-        glVertex2f(-15, 15);
-        glVertex2f(15, 15);
-        glEnd();
-    }
-    else if (enemy.type == 2) { // Square enemy
-        glColor3f(0.8, 0.0, 0.8);
-        glBegin(GL_QUADS);
-        glVertex2f(-15, -15);
-        glVertex2f(15, -15);
-        glVertex2f(15, 15);
-        glVertex2f(-15, 15);
-        glEnd();
-    }
-    else { // Enemy type 3: DDA Line Diamond 🌟
-        glColor3f(0.0, 1.0, 1.0); // Cyan color
-        glLineWidth(2.0); // Make the lines thicker for visibility
-
-        // Draw the four sides of a diamond using the DDA algorithm
-        float size = 20.0f;
-
-        // 1. Top to Right
-        drawLineDDA(0, size, size, 0);
-        // 2. Right to Bottom
-        drawLineDDA(size, 0, 0, -size);
-        // 3. Bottom to Left
-        drawLineDDA(0, -size, -size, 0);
-        // 4. Left to Top
-        drawLineDDA(-size, 0, 0, size);
-
-        glLineWidth(1.0);
+    for (int frame = 0; frame < 60; frame++) {
+        emitParticles(200, 300, style, style.color); // Warm up to the steady state
+        updateParticles(dt);
+    }
+    std::vector<double> times(FRAMES);
+    long long live = 0, allocationsBefore = allocationCount;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        NoAllocationScope steady(true);
+        auto start = std::chrono::steady_clock::now();
+        emitParticles(200, 300, style, style.color);
+        updateParticles(dt);
+        int begin[2], count[2];
+        int pieces = particlePieces(begin, count);
+        int total = (int)(particles.head - particles.tail);
+        unsigned char* lives = staging.data() + total * 2 * sizeof(float);
+        unsigned char* colors = lives + total * sizeof(float);
+        for (int k = 0, done = 0; k < pieces; done += count[k], k++) {
+            memcpy(staging.data() + done * 2 * sizeof(float), particles.position.data() + 2 * begin[k], count[k] * 2 * sizeof(float));
+            memcpy(lives + done * sizeof(float), particles.life.data() + begin[k], count[k] * sizeof(float));
+            memcpy(colors + done * 4, particles.color.data() + 4 * begin[k], count[k] * 4);
+        }
+        times[frame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        live += total;
     }
+    long long allocations = allocationCount - allocationsBefore;
 
-    glPopMatrix();
+    std::sort(times.begin(), times.end());
+    printf("Space Defender particle bench\n");
+    printf("  %d frames, %.0f particles live on average, capacity %d, kernels %s\n",
+        FRAMES, (double)live / FRAMES, particles.capacity, simd.name);
+    printf("  frame:       %.3f ms p50, %.3f ms p99, %.1f ns per particle\n",
+        times[FRAMES / 2], times[FRAMES * 99 / 100], times[FRAMES / 2] * 1e6 / std::max(1.0, (double)live / FRAMES));
+    printf("  overwritten: %lld, allocations %lld\n", particles.overwritten, allocations);
+    return 0;
 }
 
-// Draw power-up (Green pulsing circle)
-void drawPowerUp(float x, float y) {
-    glPushMatrix();
-    glTranslatef(x, y, 0);
+// Play a recorded session back at full speed (No window, no pacing)
+int runReplay(const char* path) {
+    Replay replay;
+    if (!replayLoad(path, replay)) return 1;
 
-    // Scaling animation (pulsing)
-    float scale = 1.0 + 0.2 * sin(glutGet(GLUT_ELAPSED_TIME) * 0.01);
-    glScalef(scale, scale, 1.0);
+    forcedSpawnRate = replay.forcedSpawnRate;
+    spawnBurst = replay.spawnBurst;
+    waveScripts = replay.waves;
+    fireCooldownTicks = replay.fireCooldown;
+    legacyFire = replay.legacyFire;
+    sweptContacts = replay.sweptContacts;
+    setTickRate(replay.tickRate);
+    playfield = replay.playfield;
+    poolConfig = replay.pools;
+    allocatePools(); // Not done by main for replays: the pools are sized by the file
+    world.reset(replay.seed);
 
-    glColor3f(0.0, 1.0, 0.0);
-    drawFilledCircle(0, 0, 10);
+    long long nextRecord = 0, games = 0;
+    InputIntent held; // Key bits stay until the next record, presses only last one tick
+    auto start = std::chrono::steady_clock::now();
 
-    // Draw '+' sign
-    glColor3f(1.0, 1.0, 1.0);
-    glBegin(GL_LINES);
-    glVertex2f(-5, 0);
-    glVertex2f(5, 0);
-    glVertex2f(0, -5);
-    glVertex2f(0, 5);
-    glEnd();
+    while (true) {
+        uint64_t delta;
+        if (!getVarint(replay, delta) || replay.cursor >= replay.data.size()) break;
+        nextRecord += (long long)delta;
+        while (world.tick < nextRecord) {
+            stepTick(held);
+        }
 
-    glPopMatrix();
+        unsigned char bits = replay.data[replay.cursor++];
+        if (bits == REPLAY_END) break;
+        uint64_t presses;
+        if (!getVarint(replay, presses)) break;
+
+        held.bits = bits;
+        InputIntent intent = held;
+        intent.presses = (int)presses;
+        bool waiting = world.gameState != PLAYING;
+        stepTick(intent);
+        if (waiting && world.gameState == PLAYING) games++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Space Defender replay '%s'\n", path);
+    printf("  seed %llu, %lld ticks, %lld games started, kernels %s\n",
+        (unsigned long long)replay.seed, world.tick, games, simd.name);
+    printf("  rules:       %d Hz, %s contacts, %s fire\n",
+        replay.tickRate, replay.sweptContacts ? "swept" : "endpoint", replay.legacyFire ? "per-press" : "limited");
+    printf("  time:        %.1f ms total, %.1f ns/tick (%.0fx real time)\n",
+        seconds * 1000, seconds * 1e9 / std::max(1LL, world.tick), world.tick * tickSeconds / std::max(seconds, 1e-9));
+    printf("  final state: score %d, lives %d, level %d, checksum %016llx\n",
+        world.player.score, world.player.lives, world.currentLevel, (unsigned long long)stateChecksum(world));
+    return 0;
 }
 
-// Draw HUD (Score, Lives, Level, Life Icons)
-void drawHUD() {
-    glColor3f(1.0, 1.0, 1.0);
+// === PERF SUITE ===
+// --perf-suite: canned stress scenarios through the real update() and display(), compared
+// with stored baselines. A scenario sets the stress rules below and plays PERF_TICKS ticks
+// with the headless script, then builds the batched shapes of PERF_FRAMES frames on the CPU
+// without GL (Times are the median of PERF_RUNS runs). With a display it also renders
+// PERF_FRAMES frames into the offscreen render target, one tick per frame, uncapped and on
+// the batched path.
+// Counts and memory are the same on every machine and are compared with the committed
+// baseline (--perf-baseline=FILE, default perf-baseline.txt). Times only mean something on
+// the build and machine that measured them, so they are kept in a local file
+// (--perf-times=FILE, default perf-times.txt, not committed) that records its host key and
+// is only compared on the same one. A metric regresses when it exceeds its baseline by more
+// than the tolerance (Times: --perf-tolerance=PCT, default 25, plus the spread between the
+// runs of the baseline and of this run; memory 10%; allocations not at all) plus a small
+// absolute slack. Regressions fail the run, and so do metrics missing from one side of a
+// baseline they can be compared with (Render metrics are not missing under
+// --perf-no-render, or from a baseline recorded without a display). --perf-update stores
+// the measured values as the new baselines.
+const long long PERF_TICKS = 50000;
+const int PERF_RUNS = 5;
+const int PERF_WARMUP_FRAMES = 60;
+const int PERF_FRAMES = 600;
 
-    // Lives Text
-    char livesText[20];
-    sprintf(livesText, "Lives: %d", player.lives);
-    drawText(10, HEIGHT - 30, livesText);
+struct PerfScenario {
+    const char* name;
+    int startLevel;
+    int spawnRate;     // forcedSpawnRate (0 = by level)
+    int burst;         // spawnBurst
+    int fireEvery;     // Scripted shots (0 = never)
+    int fireCooldown;  // fireCooldownTicks
+    int powerUpPeriod; // 0 = POWER_UP_PERIOD
+    bool idle;         // Never press SPACE: the game stays in MENU
+};
 
-    // Score Text
-    char scoreText[20];
-    sprintf(scoreText, "Score: %d", player.score);
-    drawText(WIDTH - 120, HEIGHT - 30, scoreText);
+const PerfScenario perfScenarios[] = {
+    { "level3-spawn1", 3, 1, 1, 10, 6, 0, false },
+    { "bullet-storm", 1, 2, 4, 1, 0, 0, false },
+    { "max-powerups", 1, 0, 1, 10, 6, 1, false },
+    { "menu-idle", 1, 0, 1, 0, 6, 0, true },
+};
+const int PERF_SCENARIOS = sizeof(perfScenarios) / sizeof(perfScenarios[0]);
 
-    // Current Level Text
-    char levelText[20];
-    sprintf(levelText, "Level: %d", currentLevel);
-    drawText(WIDTH / 2 - 40, HEIGHT - 30, levelText);
+enum PerfMetricKind { PERF_TIME, PERF_COUNT, PERF_MEMORY };
 
-    // Draw life icons
-    for (int i = 0; i < player.lives; i++) {
-        glColor3f(1.0, 0.0, 0.0);
-        drawFilledCircle(20 + i * 25, HEIGHT - 60, 8);
-    }
-}
+enum PerfMetricId {
+    PERF_TICK,              // Whole step, wall clock
+    PERF_UPDATE,            // PROFILE_UPDATE
+    PERF_COLLISIONS,
+    PERF_CLEANUP,
+    PERF_ALLOCATIONS,       // operator new calls during the ticks
+    PERF_PEAK,              // Process-wide peak during the ticks above the live bytes at their start
+    PERF_BATCH,             // Bullets, enemies and power-ups built into the batch, CPU only
+    PERF_FRAME,             // display() on the CPU (Render metrics from here on: need a display)
+    PERF_SHAPES,            // Player, bullets, enemies and power-ups sections of display()
+    PERF_GPU,               // Whole frame on the GPU (Needs timer queries)
+    PERF_FRAME_ALLOCATIONS, // operator new calls during the frames
+    PERF_METRIC_COUNT
+};
 
-// Draw menu
-void drawMenu() {
-    glColor3f(0.0, 1.0, 1.0);
-    drawText(WIDTH / 2 - 100, HEIGHT / 2 + 50, "SPACE DEFENDER");
+struct PerfMetric {
+    const char* name;
+    const char* unit;
+    PerfMetricKind kind;
+    double slack; // Absolute, in the unit
+};
 
-    glColor3f(1.0, 1.0, 1.0);
-    drawText(WIDTH / 2 - 120, HEIGHT / 2, "Press SPACE to Start");
-    drawText(WIDTH / 2 - 80, HEIGHT / 2 - 40, "Controls:");
-    drawText(WIDTH / 2 - 100, HEIGHT / 2 - 70, "Arrows - Move");
-    drawText(WIDTH / 2 - 100, HEIGHT / 2 - 90, "SPACE - Shoot");
-    drawText(WIDTH / 2 - 100, HEIGHT / 2 - 110, "ESC - Quit");
-    drawText(WIDTH / 2 - 100, HEIGHT / 2 - 130, "A/D/W/S - Also work");
-}
+const PerfMetric perfMetrics[PERF_METRIC_COUNT] = {
+    { "tick", "us", PERF_TIME, 0.05 },
+    { "update", "us", PERF_TIME, 0.05 },
+    { "collisions", "us", PERF_TIME, 0.05 },
+    { "cleanup", "us", PERF_TIME, 0.05 },
+    { "allocations", "", PERF_COUNT, 0 },
+    { "peak-growth", "KB", PERF_MEMORY, 16 },
+    { "batch", "us", PERF_TIME, 0.5 },
+    { "frame", "ms", PERF_TIME, 0.02 },
+    { "shapes", "ms", PERF_TIME, 0.02 },
+    { "gpu", "ms", PERF_TIME, 0.02 },
+    { "frame-allocations", "", PERF_COUNT, 0 },
+};
 
-// Draw game over screen (Including requested text)
-void drawGameOver() {
-    glColor3f(1.0, 0.0, 0.0);
-    drawText(WIDTH / 2 - 80, HEIGHT / 2 + 70, "JOY BANGLA"); // Requested text
-    drawText(WIDTH / 2 - 80, HEIGHT / 2 + 50, "GAME OVER");
+struct PerfResult {
+    double value[PERF_METRIC_COUNT] = {};  // Times: median of the runs
+    double spread[PERF_METRIC_COUNT] = {}; // Times: slowest minus fastest run
+    double runs[PERF_METRIC_COUNT][PERF_RUNS];
+    bool measured[PERF_METRIC_COUNT] = {};
+};
 
-    glColor3f(1.0, 1.0, 1.0);
-    char scoreText[50];
-    sprintf(scoreText, "Final Score: %d", player.score);
-    drawText(WIDTH / 2 - 80, HEIGHT / 2, scoreText);
-    drawText(WIDTH / 2 - 120, HEIGHT / 2 - 40, "Press SPACE to Restart");
-    drawText(WIDTH / 2 - 80, HEIGHT / 2 - 70, "Press ESC to Quit");
-}
+struct PerfBaselineEntry {
+    std::string scenario, metric;
+    double value;
+    double spread;
+};
 
-// Update game logic (Called 60 times per second)
-void update(int value) {
-    if (gameState == PLAYING) {
-        // Update background animation
-        starOffset += 0.5;
-        if (starOffset > HEIGHT) starOffset = 0;
+struct PerfSuite {
+    const char* baselinePath = "perf-baseline.txt"; // Counts and memory (Committed)
+    const char* timesPath = "perf-times.txt";       // Times of this host (Local)
+    bool update = false;    // --perf-update
+    bool render = true;     // --perf-no-render
+    bool rendered = false;  // The render phase ran (A display was available)
+    double tolerance = 0.25;
+    PerfResult results[PERF_SCENARIOS];
+    GameSnapshot view;      // CPU batch phase (Reserved for full pools)
 
-        // --- Timer Increments ---
-        enemySpawnTimer++;
-        powerUpTimer++;
-        gameLevelTimer++;
-        lastHitTimer++;
+    // Render phase (GLUT idle callback)
+    int scenario = 0;
+    int frame = 0;
+    long long tick = 0;
+    BenchPlayer script;
+    uint64_t profileBefore[PROFILE_SECTION_COUNT];
+    uint32_t gpuSamplesBefore = 0;
+    long long allocationsBefore = 0;
+} perfSuite;
 
-        // --- 1. Level Management (Every 15 seconds) ---
-        if (gameLevelTimer >= 900) {
-            if (currentLevel < 3) {
-                currentLevel++;
-                // MODIFIED: Increase difficulty steeply
-                enemySpawnRate = 60 - (currentLevel - 1) * 25;
-            }
-            gameLevelTimer = 0;
-        }
+void profileTotals(uint64_t totals[PROFILE_SECTION_COUNT]) {
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        totals[i] = profileRings[i].total.load(std::memory_order_relaxed);
+    }
+}
 
-        // --- 2. Player Penalty (If no hit for 5 seconds) ---
-        if (lastHitTimer >= 300) {
-            if (player.lives > 0) {
-                player.lives--;
-                lastHitTimer = 0;
-            }
-            if (player.lives <= 0) {
-                gameState = GAME_OVER;
-            }
-        }
+// Set the rules of a scenario (Shared with every World, like the benchmark overrides)
+BenchConfig perfApply(const PerfScenario& scenario) {
+    startLevel = scenario.startLevel;
+    forcedSpawnRate = scenario.spawnRate;
+    spawnBurst = scenario.burst;
+    fireCooldownTicks = scenario.fireCooldown;
+    powerUpPeriod = scenario.powerUpPeriod;
+    BenchConfig config;
+    config.ticks = PERF_TICKS;
+    config.fireEvery = scenario.fireEvery;
+    return config;
+}
 
-        // Update player position based on key presses
-        if (keys['a'] || keys['A']) {
-            player.x -= player.speed;
-            if (player.x < player.size) player.x = player.size;
-        }
-        if (keys['d'] || keys['D']) {
-            player.x += player.speed;
-            if (player.x > WIDTH - player.size) player.x = WIDTH - player.size;
-        }
-        if (keys['w'] || keys['W']) {
-            player.y += player.speed;
-            if (player.y > HEIGHT - player.size) player.y = HEIGHT - player.size;
-        }
-        if (keys['s'] || keys['S']) {
-            player.y -= player.speed;
-            if (player.y < player.size) player.y = player.size;
-        }
+BenchPlayer perfPlayer(const PerfScenario& scenario) {
+    BenchPlayer script;
+    script.starts = scenario.idle ? 0 : 1;
+    return script;
+}
 
-        // Update bullets
-        for (auto& bullet : bullets) {
-            if (bullet.active) {
-                bullet.y += bullet.speed;
-                if (bullet.y > HEIGHT) bullet.active = false;
-            }
-        }
+// One tick of a scenario with its scripted player (Who restarts after a game over)
+void perfStep(const PerfScenario& scenario, BenchPlayer& script, long long tick, const BenchConfig& config) {
+    world.step(benchInput(script, tick, config));
+    if (!scenario.idle && world.gameState == GAME_OVER) script.starts++;
+}
 
-        // Spawn enemies
-        if (enemySpawnTimer > enemySpawnRate) {
-            Enemy enemy;
-            enemy.x = rand() % (WIDTH - 40) + rand() % 20;
-            enemy.y = HEIGHT;
+// One run of a scenario's ticks; times keep the best run, counts come from the first
+void perfTicks(const PerfScenario& scenario, int run, PerfResult& result) {
+    BenchConfig config = perfApply(scenario);
+    world.reset(config.seed);
+    BenchPlayer script = perfPlayer(scenario);
+    uint64_t before[PROFILE_SECTION_COUNT], after[PROFILE_SECTION_COUNT];
+    memoryResetPeaks();
+    long long liveBefore = memoryProcess.live.load(std::memory_order_relaxed);
+    long long allocationsBefore = allocationCount;
+    profileTotals(before);
+    auto start = std::chrono::steady_clock::now();
+    for (long long tick = 0; tick < config.ticks; tick++) {
+        perfStep(scenario, script, tick, config);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    profileTotals(after);
 
-            // MODIFIED: Enemy speed increases with level
-            enemy.speed = 2.0 + (rand() % 3) + (currentLevel * 0.5);
+    // Microseconds per tick
+    double times[4] = { seconds * 1e6 / config.ticks,
+        (after[PROFILE_UPDATE] - before[PROFILE_UPDATE]) / 1e3 / config.ticks,
+        (after[PROFILE_COLLISIONS] - before[PROFILE_COLLISIONS]) / 1e3 / config.ticks,
+        (after[PROFILE_CLEANUP] - before[PROFILE_CLEANUP]) / 1e3 / config.ticks };
+    for (int m = PERF_TICK; m <= PERF_CLEANUP; m++) {
+        result.runs[m][run] = times[m];
+        result.measured[m] = true;
+    }
+    if (run == 0) {
+        result.value[PERF_ALLOCATIONS] = (double)(allocationCount - allocationsBefore);
+        result.value[PERF_PEAK] = (memoryProcess.peak.load(std::memory_order_relaxed) - liveBefore) / 1024.0;
+        result.measured[PERF_ALLOCATIONS] = result.measured[PERF_PEAK] = true;
+    }
+}
 
-            enemy.active = true;
-            enemy.type = rand() % 4;
-            enemies.push_back(enemy);
-            enemySpawnTimer = 0;
+// One run of a scenario's batch building: a tick, then the bullets, enemies and power-ups
+// of display() at full detail into the batch (No GL, so it runs without a display)
+void perfBatch(const PerfScenario& scenario, int run, PerfResult& result) {
+    PerfSuite& suite = perfSuite;
+    BenchConfig config = perfApply(scenario);
+    world.reset(config.seed);
+    BenchPlayer script = perfPlayer(scenario);
+    const GameSnapshot& view = suite.view;
+    double seconds = 0;
+    for (int frame = 0; frame < PERF_WARMUP_FRAMES + PERF_FRAMES; frame++) {
+        perfStep(scenario, script, frame, config);
+        world.observe(suite.view);
+        auto start = std::chrono::steady_clock::now();
+        arenaReset(frameArena);
+        batchBegin();
+        if (view.state == PLAYING) {
+            batchLayer(LAYER_BULLETS);
+            for (int i = 0; i < view.bullets.count; i++) drawBullet(view.bullets.x[i], view.bullets.y[i], view.level);
+            batchLayer(LAYER_ENEMIES);
+            drawEnemies(view.enemies, 1, frame * 1.6f, LOD_FULL);
+            batchLayer(LAYER_POWERUPS);
+            for (int i = 0; i < view.powerUps.count; i++) drawPowerUp(view.powerUps.x[i], view.powerUps.y[i], 1, LOD_FULL);
         }
+        if (frame >= PERF_WARMUP_FRAMES) seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
 
-        // Update enemies & Check collision with player
-        for (auto& enemy : enemies) {
-            if (enemy.active) {
-                enemy.y -= enemy.speed;
-                if (enemy.y < -30) enemy.active = false;
+    // Microseconds per frame
+    result.runs[PERF_BATCH][run] = seconds * 1e6 / PERF_FRAMES;
+    result.measured[PERF_BATCH] = true;
+}
 
-                // Check collision with player
-                float dx = enemy.x - player.x;
-                float dy = enemy.y - player.y;
-                float distance = sqrt(dx * dx + dy * dy);
-                if (distance < player.size + 15) {
-                    enemy.active = false;
-                    player.lives--;
-                    if (player.lives <= 0) {
-                        gameState = GAME_OVER;
-                    }
-                }
-            }
-        }
+// Reduce the runs of every repeated time to their median and spread
+void perfSummarize(PerfResult& result) {
+    for (int m = PERF_TICK; m <= PERF_BATCH; m++) {
+        if (!result.measured[m] || perfMetrics[m].kind != PERF_TIME) continue;
+        double* runs = result.runs[m];
+        std::sort(runs, runs + PERF_RUNS);
+        result.value[m] = runs[PERF_RUNS / 2];
+        result.spread[m] = runs[PERF_RUNS - 1] - runs[0];
+    }
+}
 
-        // Check bullet-enemy collision (Resets lastHitTimer)
-        for (auto& bullet : bullets) {
-            if (bullet.active) {
-                for (auto& enemy : enemies) {
-                    if (enemy.active) {
-                        float dx = bullet.x - enemy.x;
-                        float dy = bullet.y - enemy.y;
-                        float distance = sqrt(dx * dx + dy * dy);
-                        if (distance < 20) { // Collision Radius
-                            bullet.active = false;
-                            enemy.active = false;
-                            player.score += 10;
-                            // Reset the timer on successful hit
-                            lastHitTimer = 0;
-                        }
-                    }
-                }
-            }
-        }
+// Compiler flags go into the host key: build with -DSD_BUILD_FLAGS='"-O3 -march=native"' to
+// record them exactly. Without it the macros the flags predefine stand in (They tell -O0,
+// -Os, the ISA extensions and fast math apart, but not -O1 from -O2 or -O3).
+#ifndef SD_BUILD_FLAGS
+#if defined(__OPTIMIZE_SIZE__)
+#define SD_OPT_FLAGS "-Os"
+#elif defined(__OPTIMIZE__) || (defined(_MSC_VER) && !defined(_DEBUG))
+#define SD_OPT_FLAGS "optimized (level unrecorded)"
+#else
+#define SD_OPT_FLAGS "-O0"
+#endif
+#if defined(__AVX512F__)
+#define SD_ISA_FLAGS " avx512f"
+#elif defined(__AVX2__)
+#define SD_ISA_FLAGS " avx2"
+#elif defined(__AVX__)
+#define SD_ISA_FLAGS " avx"
+#elif defined(__SSE4_2__)
+#define SD_ISA_FLAGS " sse4.2"
+#else
+#define SD_ISA_FLAGS ""
+#endif
+#ifdef __FAST_MATH__
+#define SD_MATH_FLAGS " fast-math"
+#else
+#define SD_MATH_FLAGS ""
+#endif
+#define SD_BUILD_FLAGS SD_OPT_FLAGS SD_ISA_FLAGS SD_MATH_FLAGS
+#endif
 
-        // Spawn power-ups (Every 5 seconds/300 frames)
-        if (powerUpTimer > 300) {
-            PowerUp powerUp;
-            powerUp.x = rand() % (WIDTH - 40) + 20;
-            powerUp.y = HEIGHT;
-            powerUp.speed = 1.5;
-            powerUp.active = true;
-            powerUps.push_back(powerUp);
-            powerUpTimer = 0;
-        }
-
-        // Update power-ups
-        for (auto& powerUp : powerUps) {
-            if (powerUp.active) {
-                powerUp.y -= powerUp.speed;
-                if (powerUp.y < -20) powerUp.active = false;
-
-                // Check collision with player
-                float dx = powerUp.x - player.x;
-                float dy = powerUp.y - player.y;
-                float distance = sqrt(dx * dx + dy * dy);
-                if (distance < player.size + 10) {
-                    powerUp.active = false;
-                    if (player.lives < 5) player.lives++; // Max 5 lives
-                    player.score += 20;
-                }
-            }
-        }
+// The build and machine the times belong to (Header of the times file)
+std::string perfHostKey() {
+#if defined(__clang__)
+    const char* compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    const char* compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    char compiler[32];
+    snprintf(compiler, sizeof(compiler), "msvc %d", _MSC_FULL_VER);
+#else
+    const char* compiler = "unknown compiler";
+#endif
+    char key[384];
+    snprintf(key, sizeof(key), "%s, flags %s, kernels %s, %d job threads, %u cores, %d Hz", compiler, SD_BUILD_FLAGS,
+        simd.name, jobs.threads, std::thread::hardware_concurrency(), tickRate);
+    return key;
+}
 
-        // Remove inactive objects (Cleanup)
-        bullets.erase(std::remove_if(bullets.begin(), bullets.end(),
-            [](const Bullet& b) { return !b.active; }), bullets.end());
-        enemies.erase(std::remove_if(enemies.begin(), enemies.end(),
-            [](const Enemy& e) { return !e.active; }), enemies.end());
-        powerUps.erase(std::remove_if(powerUps.begin(), powerUps.end(),
-            [](const PowerUp& p) { return !p.active; }), powerUps.end());
+// times: keep the time metrics (The times file) or everything else (The committed baseline)
+std::vector<PerfBaselineEntry> perfLoadBaseline(const char* path, bool times, std::string& host) {
+    std::vector<PerfBaselineEntry> baseline;
+    FILE* file = fopen(path, "r");
+    if (!file) return baseline;
+    char line[512], scenario[64], metric[64];
+    double value, spread;
+    const char* HOST = "# Host: ";
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, HOST, strlen(HOST)) == 0) {
+            host = line + strlen(HOST);
+            while (!host.empty() && (host.back() == '\n' || host.back() == '\r')) host.pop_back();
+        }
+        if (line[0] == '#') continue;
+        int fields = sscanf(line, "%63s %63s %lf %lf", scenario, metric, &value, &spread);
+        bool kept = false;
+        for (const PerfMetric& known : perfMetrics) {
+            if (strcmp(known.name, metric) == 0) kept = (known.kind == PERF_TIME) == times;
+        }
+        if (fields >= 3 && kept) baseline.push_back({ scenario, metric, value, fields == 4 ? spread : 0 });
     }
-
-    glutPostRedisplay();
-    glutTimerFunc(16, update, 0); // Next frame in 16ms (~60 FPS)
+    fclose(file);
+    return baseline;
 }
 
-// Display function (Renders everything)
-void display() {
-    glClear(GL_COLOR_BUFFER_BIT);
+PerfBaselineEntry* perfFind(std::vector<PerfBaselineEntry>& baseline, const char* scenario, const char* metric) {
+    for (PerfBaselineEntry& entry : baseline) {
+        if (entry.scenario == scenario && entry.metric == metric) return &entry;
+    }
+    return NULL;
+}
 
-    drawStars(); // Draw background first
+// spread: of the baseline's runs and of this run's together (Times only)
+bool perfRegressed(const PerfMetric& metric, double value, double base, double spread, double tolerance) {
+    switch (metric.kind) {
+    case PERF_TIME: return value > base * (1 + tolerance) + spread + metric.slack;
+    case PERF_MEMORY: return value > base * 1.10 + metric.slack;
+    case PERF_COUNT: return value > base;
+    }
+    return false;
+}
 
-    if (gameState == MENU) {
-        drawMenu();
+// Write one baseline file (host: the key line of the times file, NULL for the counts)
+bool perfWriteBaseline(const char* path, const char* host, const std::vector<PerfBaselineEntry>& entries) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write perf baseline %s\n", path);
+        return false;
+    }
+    fprintf(file, "# Space Defender perf baseline (--perf-suite --perf-update): scenario metric value%s\n",
+        host ? " spread" : "");
+    if (host) fprintf(file, "# Host: %s\n", host);
+    for (const PerfBaselineEntry& entry : entries) {
+        if (host) fprintf(file, "%s %s %.4f %.4f\n", entry.scenario.c_str(), entry.metric.c_str(), entry.value, entry.spread);
+        else fprintf(file, "%s %s %.4f\n", entry.scenario.c_str(), entry.metric.c_str(), entry.value);
     }
-    else if (gameState == PLAYING) {
-        drawPlayer();
+    fclose(file);
+    printf("  baseline:    written to %s\n", path);
+    return true;
+}
 
-        // Draw active bullets
-        for (auto& bullet : bullets) {
-            if (bullet.active) {
-                drawBullet(bullet.x, bullet.y);
+// Compare every measured metric with its baseline, print the table and store the new
+// baselines if asked. Returns the exit code (1 when something regressed, or a comparable
+// metric is only in the baseline or only in this run; render metrics only count as new
+// against a baseline that was recorded with a display).
+int perfReport() {
+    PerfSuite& suite = perfSuite;
+    std::string host, unused, here = perfHostKey();
+    std::vector<PerfBaselineEntry> counts = perfLoadBaseline(suite.baselinePath, false, unused);
+    std::vector<PerfBaselineEntry> times = perfLoadBaseline(suite.timesPath, true, host);
+    bool sameHost = !times.empty() && host == here;
+    // Times measured on another build or machine say nothing here; counts and memory do
+    auto baselineOf = [&](const PerfMetric& metric) -> std::vector<PerfBaselineEntry>& {
+        return metric.kind == PERF_TIME ? times : counts;
+        };
+    auto comparable = [&](const PerfMetric& metric) {
+        return metric.kind == PERF_TIME ? sameHost : !counts.empty();
+        };
+    // A baseline recorded without a display has no render metrics to miss
+    auto rendered = [&](const std::vector<PerfBaselineEntry>& baseline) {
+        for (const PerfBaselineEntry& entry : baseline) {
+            for (int m = PERF_FRAME; m < PERF_METRIC_COUNT; m++) {
+                if (entry.metric == perfMetrics[m].name) return true;
             }
         }
+        return false;
+        };
+    bool renderedCounts = rendered(counts), renderedTimes = rendered(times);
+    int regressions = 0, missing = 0, fresh = 0;
 
-        // Draw active enemies
-        for (auto& enemy : enemies) {
-            if (enemy.active) {
-                drawEnemy(enemy);
+    printf("Space Defender perf suite\n");
+    printf("  %lld ticks (median of %d) per scenario at %d Hz, kernels %s, %d job threads\n",
+        PERF_TICKS, PERF_RUNS, tickRate, simd.name, jobs.threads);
+    printf("  host:        %s\n", here.c_str());
+    printf("  counts:      %s%s, memory within 10%%\n", suite.baselinePath, counts.empty() ? " (none yet)" : "");
+    printf("  times:       %s%s, within %.0f%% plus the run spread\n", suite.timesPath,
+        times.empty() ? " (none yet)" : sameHost ? "" : " (another host: not compared)", suite.tolerance * 100);
+    if (!times.empty() && !sameHost) printf("  times from:  %s\n", host.empty() ? "unknown" : host.c_str());
+    printf("  %-14s %-18s %12s %12s %8s\n", "scenario", "metric", "value", "baseline", "change");
+    for (int s = 0; s < PERF_SCENARIOS; s++) {
+        const PerfResult& result = suite.results[s];
+        for (int m = 0; m < PERF_METRIC_COUNT; m++) {
+            const PerfMetric& metric = perfMetrics[m];
+            PerfBaselineEntry* entry = perfFind(baselineOf(metric), perfScenarios[s].name, metric.name);
+            char shown[32] = "-", based[32] = "-", change[16] = "";
+            if (entry) snprintf(based, sizeof(based), "%.3f %s", entry->value, metric.unit);
+            const char* verdict;
+            if (!result.measured[m]) {
+                // In the baseline but not measured (No display or no GPU timer queries)
+                if (!entry || (!suite.render && m >= PERF_FRAME)) continue;
+                verdict = comparable(metric) ? "MISSING" : "not run";
+                missing += comparable(metric);
+            }
+            else if (entry) {
+                double value = result.value[m];
+                snprintf(shown, sizeof(shown), "%.3f %s", value, metric.unit);
+                if (entry->value > 0) snprintf(change, sizeof(change), "%+.1f%%", (value / entry->value - 1) * 100);
+                bool regressed = comparable(metric)
+                    && perfRegressed(metric, value, entry->value, entry->spread + result.spread[m], suite.tolerance);
+                verdict = !comparable(metric) ? "other host" : regressed ? "REGRESSED" : "ok";
+                regressions += regressed;
+            }
+            else {
+                snprintf(shown, sizeof(shown), "%.3f %s", result.value[m], metric.unit);
+                bool expected = comparable(metric)
+                    && (m < PERF_FRAME || (metric.kind == PERF_TIME ? renderedTimes : renderedCounts));
+                verdict = expected ? "NEW" : "new";
+                fresh += expected;
             }
+            printf("  %-14s %-18s %12s %12s %8s  %s\n", perfScenarios[s].name, metric.name, shown, based, change, verdict);
         }
+    }
+    if (!suite.rendered) printf("  render:      skipped (%s)\n", suite.render ? "No display" : "--perf-no-render");
+    printf("  result:      %d regressions, %d metrics not measured, %d not in the baseline\n", regressions, missing, fresh);
 
-        // Draw active power-ups
-        for (auto& powerUp : powerUps) {
-            if (powerUp.active) {
-                drawPowerUp(powerUp.x, powerUp.y);
+    if (suite.update) {
+        // Times from another host are replaced, not merged
+        if (!sameHost) times.clear();
+        for (int s = 0; s < PERF_SCENARIOS; s++) {
+            const PerfResult& result = suite.results[s];
+            for (int m = 0; m < PERF_METRIC_COUNT; m++) {
+                if (!result.measured[m]) continue;
+                const PerfMetric& metric = perfMetrics[m];
+                std::vector<PerfBaselineEntry>& baseline = baselineOf(metric);
+                PerfBaselineEntry* entry = perfFind(baseline, perfScenarios[s].name, metric.name);
+                if (!entry) {
+                    baseline.push_back({ perfScenarios[s].name, metric.name, 0, 0 });
+                    entry = &baseline.back();
+                }
+                entry->value = result.value[m];
+                entry->spread = result.spread[m];
             }
         }
-
-        drawHUD(); // Draw HUD last so it's on top
-    }
-    else if (gameState == GAME_OVER) {
-        drawGameOver();
+        bool written = perfWriteBaseline(suite.baselinePath, NULL, counts);
+        written = perfWriteBaseline(suite.timesPath, here.c_str(), times) && written;
+        return written ? 0 : 1;
     }
+    return regressions + missing + fresh > 0 ? 1 : 0;
+}
 
-    glutSwapBuffers();
+void perfRenderBegin() {
+    PerfSuite& suite = perfSuite;
+    const PerfScenario& scenario = perfScenarios[suite.scenario];
+    perfApply(scenario);
+    world.reset(1);
+    suite.script = perfPlayer(scenario);
+    suite.tick = 0;
+    suite.frame = 0;
+    idle.cached = false;
+    idle.shown = IdleView();
 }
 
-// Keyboard input handlers
-void keyboardDown(unsigned char key, int x, int y) {
-    keys[key] = true;
+// GLUT idle callback of the render phase: one tick and one frame per call, like
+// single-threaded play (An unchanged idle screen is not redrawn, as in gameLoop)
+void perfRenderIdle() {
+    PerfSuite& suite = perfSuite;
+    const PerfScenario& scenario = perfScenarios[suite.scenario];
+    if (suite.frame == PERF_WARMUP_FRAMES) {
+        profileTotals(suite.profileBefore);
+        suite.gpuSamplesBefore = profileRings[PROFILE_GPU].head.load(std::memory_order_relaxed);
+        suite.allocationsBefore = allocationCount;
+    }
 
-    if (key == 27) { // ESC
-        exit(0);
+    BenchConfig config = perfApply(scenario);
+    perfStep(scenario, suite.script, suite.tick++, config);
+    publishSnapshot(std::chrono::steady_clock::now());
+    const GameSnapshot& frame = latestSnapshot();
+    bool draw = true;
+    if (idle.enabled && frame.state != PLAYING) {
+        idle.pending = idleDamage(idleView(frame));
+        if (idle.pending == DAMAGE_NONE) {
+            idle.pending = DAMAGE_FULL;
+            draw = false;
+        }
     }
+    if (draw) display();
+    if (++suite.frame < PERF_WARMUP_FRAMES + PERF_FRAMES) return;
 
-    if (key == ' ') {
-        if (gameState == MENU || gameState == GAME_OVER) {
-            gameState = PLAYING;
-            // Reset all game variables for restart
-            player.lives = 3;
-            player.score = 0;
-            player.x = WIDTH / 2;
-            player.y = 50;
-            bullets.clear();
-            enemies.clear();
-            powerUps.clear();
+    // Milliseconds per frame (Skipped idle frames included), the GPU per timed frame
+    glFinish();
+    uint64_t after[PROFILE_SECTION_COUNT];
+    profileTotals(after);
+    PerfResult& result = suite.results[suite.scenario];
+    auto perFrame = [&](ProfileSection section) {
+        return (after[section] - suite.profileBefore[section]) / 1e6 / PERF_FRAMES;
+        };
+    result.value[PERF_FRAME] = perFrame(PROFILE_RENDER);
+    result.value[PERF_SHAPES] = perFrame(PROFILE_PLAYER) + perFrame(PROFILE_BULLETS) + perFrame(PROFILE_ENEMIES) + perFrame(PROFILE_POWERUPS);
+    result.value[PERF_FRAME_ALLOCATIONS] = (double)(allocationCount - suite.allocationsBefore);
+    result.measured[PERF_FRAME] = result.measured[PERF_SHAPES] = result.measured[PERF_FRAME_ALLOCATIONS] = true;
+    uint32_t gpuSamples = profileRings[PROFILE_GPU].head.load(std::memory_order_relaxed) - suite.gpuSamplesBefore;
+    if (glext.timerQuery && gpuSamples > 0) {
+        result.value[PERF_GPU] = (after[PROFILE_GPU] - suite.profileBefore[PROFILE_GPU]) / 1e6 / gpuSamples;
+        result.measured[PERF_GPU] = true;
+    }
 
-            currentLevel = 1;
-            enemySpawnRate = 60;
-            gameLevelTimer = 0;
-            lastHitTimer = 0;
-            playerShape = 0;
-        }
-        else if (gameState == PLAYING) {
-            // Shoot bullet
-            Bullet bullet;
-            bullet.x = player.x;
-            bullet.y = player.y + player.size;
-            bullet.speed = 10.0;
-            bullet.active = true;
-            bullets.push_back(bullet);
-        }
+    if (++suite.scenario < PERF_SCENARIOS) {
+        perfRenderBegin();
+        return;
     }
+    exit(perfReport());
 }
 
-void keyboardUp(unsigned char key, int x, int y) {
-    keys[key] = false;
+bool perfHasDisplay() {
+#if defined(_WIN32) || defined(__APPLE__)
+    return true;
+#else
+    return getenv("DISPLAY") || getenv("WAYLAND_DISPLAY");
+#endif
 }
 
-// Special keyboard functions (For Arrow Keys)
-void specialDown(int key, int x, int y) {
-    switch (key) {
-    case GLUT_KEY_LEFT:
-        keys['a'] = true;
-        break;
-    case GLUT_KEY_RIGHT:
-        keys['d'] = true;
-        break;
-    case GLUT_KEY_UP:
-        keys['w'] = true;
-        break;
-    case GLUT_KEY_DOWN:
-        keys['s'] = true;
-        break;
+int runPerfSuite(int& argc, char** argv) {
+    PerfSuite& suite = perfSuite;
+    allocateWindowBuffers(); // Batch and render phases (Reserved before the ticks, not in their peak)
+    {
+        MemoryTagScope tag(MEMORY_RENDER);
+        reserveSnapshot(suite.view);
+    }
+    // Scenarios take turns, so a slow spell of the machine does not hit all runs of one
+    for (int run = 0; run < PERF_RUNS; run++) {
+        for (int s = 0; s < PERF_SCENARIOS; s++) {
+            perfTicks(perfScenarios[s], run, suite.results[s]);
+            perfBatch(perfScenarios[s], run, suite.results[s]);
+        }
     }
+    for (PerfResult& result : suite.results) perfSummarize(result);
+    if (!suite.render || !perfHasDisplay()) return perfReport();
+    suite.rendered = true;
+
+    // Render phase: a window like the game's, drawing every frame through the offscreen target
+    pacer.mode = PACE_UNCAPPED;
+    renderTarget.forced = true;
+    instanced.enabled = false;
+    lod.automatic = false;
+    lod.level = LOD_FULL;
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
+    glutInitWindowSize(playfield.width, playfield.height);
+    glutCreateWindow("Space Defender - Perf Suite");
+    init();
+    glutDisplayFunc(display);
+    glutReshapeFunc(reshape);
+    perfRenderBegin();
+    glutIdleFunc(perfRenderIdle);
+    glutMainLoop();
+    return 0;
 }
 
-void specialUp(int key, int x, int y) {
-    switch (key) {
-    case GLUT_KEY_LEFT:
-        keys['a'] = false;
-        break;
-    case GLUT_KEY_RIGHT:
-        keys['d'] = false;
-        break;
-    case GLUT_KEY_UP:
-        keys['w'] = false;
-        break;
-    case GLUT_KEY_DOWN:
-        keys['s'] = false;
-        break;
-    }
+// Value of a --name=value argument, or NULL when arg is a different option
+const char* argValue(const char* arg, const char* name) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) == 0 && arg[length] == '=') return arg + length + 1;
+    return NULL;
 }
 
 // Main function
 int main(int argc, char** argv) {
+    const char* simdOverride = NULL;
+    bool simdCheck = false;
+    bool headless = false;
+    bool snapshotCheck = false;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    int worldCount = 0;
+    int particleBench = 0;
+    bool perfSuiteRun = false;
+    int jobThreads = std::min(8, std::max(1, (int)std::thread::hardware_concurrency()));
+    BenchConfig bench;
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if ((value = argValue(argv[i], "--simd"))) simdOverride = value;
+        if ((value = argValue(argv[i], "--record"))) recordPath = value;
+        if ((value = argValue(argv[i], "--replay"))) replayPath = value;
+        if ((value = argValue(argv[i], "--jobs"))) jobThreads = atoi(value);
+        if ((value = argValue(argv[i], "--perf-baseline"))) perfSuite.baselinePath = value;
+        if ((value = argValue(argv[i], "--perf-times"))) perfSuite.timesPath = value;
+        if ((value = argValue(argv[i], "--perf-tolerance"))) perfSuite.tolerance = std::max(0.0, atof(value) / 100);
+        if ((value = argValue(argv[i], "--particles"))) particles.capacity = std::max(0, atoi(value));
+        if ((value = argValue(argv[i], "--particle-bench"))) particleBench = std::max(1, atoi(value));
+        if ((value = argValue(argv[i], "--worlds"))) worldCount = std::max(1, std::min(256, atoi(value)));
+        if ((value = argValue(argv[i], "--raster"))) rasterMode = strcmp(value, "cpu") == 0 ? RASTER_CPU : RASTER_GPU;
+        if ((value = argValue(argv[i], "--waves")) && !loadWaveScripts(value)) return 1;
+        if ((value = argValue(argv[i], "--pacing"))) {
+            for (int m = 0; m < PACE_MODE_COUNT; m++) {
+                if (strcmp(value, pacingModeNames[m]) == 0) pacer.mode = (PacingMode)m;
+            }
+        }
+        if ((value = argValue(argv[i], "--fps"))) pacer.fpsCap = std::max(0, atoi(value));
+        if ((value = argValue(argv[i], "--fire-cooldown"))) fireCooldownTicks = std::max(0, atoi(value));
+        if ((value = argValue(argv[i], "--lod-budget"))) lod.budgetMs = std::max(0.0f, (float)atof(value));
+        if ((value = argValue(argv[i], "--lod"))) {
+            for (int l = 0; l < LOD_LEVEL_COUNT; l++) {
+                if (strcmp(value, detailLevelNames[l]) == 0) {
+                    lod.automatic = false;
+                    lod.level = (DetailLevel)l;
+                }
+            }
+        }
+        if ((value = argValue(argv[i], "--render-scale"))) renderTarget.scale = std::max(0.25f, std::min(1.0f, (float)atof(value)));
+        if ((value = argValue(argv[i], "--playfield"))) {
+            int width, height;
+            if (sscanf(value, "%dx%d", &width, &height) != 2 || width < 200 || height < 200) {
+                fprintf(stderr, "--playfield needs WIDTHxHEIGHT, both at least 200\n");
+                return 1;
+            }
+            playfield.width = width;
+            playfield.height = height;
+        }
+        if ((value = argValue(argv[i], "--frame-stats"))) frameStatsPath = value;
+        if ((value = argValue(argv[i], "--ticks"))) bench.ticks = atoll(value);
+        if ((value = argValue(argv[i], "--tick-rate"))) setTickRate(atoi(value));
+        if ((value = argValue(argv[i], "--seed"))) bench.seed = strtoull(value, NULL, 10);
+        if ((value = argValue(argv[i], "--fire-every"))) bench.fireEvery = atoi(value);
+        if ((value = argValue(argv[i], "--memory-stats"))) bench.memoryStats = value;
+        if ((value = argValue(argv[i], "--memory-every"))) bench.memoryEvery = std::max(1, atoi(value));
+        if ((value = argValue(argv[i], "--spawn-rate"))) forcedSpawnRate = atoi(value);
+        if ((value = argValue(argv[i], "--burst"))) spawnBurst = std::max(1, atoi(value));
+        if ((value = argValue(argv[i], "--star-layers"))) parallaxLayers = std::max(0, atoi(value));
+        if ((value = argValue(argv[i], "--pool-bullets"))) poolConfig.bullets = std::max(1, atoi(value));
+        if ((value = argValue(argv[i], "--pool-enemies"))) poolConfig.enemies = std::max(1, atoi(value));
+        if ((value = argValue(argv[i], "--pool-powerups"))) poolConfig.powerUps = std::max(1, atoi(value));
+        if (strcmp(argv[i], "--simd-check") == 0) simdCheck = true;
+        if (strcmp(argv[i], "--headless") == 0) headless = true;
+        if (strcmp(argv[i], "--snapshot-check") == 0) snapshotCheck = true;
+        if (strcmp(argv[i], "--perf-suite") == 0) perfSuiteRun = true;
+        if (strcmp(argv[i], "--perf-update") == 0) perfSuite.update = true;
+        if (strcmp(argv[i], "--perf-no-render") == 0) perfSuite.render = false;
+        if (strcmp(argv[i], "--single-thread") == 0) singleThreaded = true;
+        if (strcmp(argv[i], "--no-instancing") == 0) instanced.enabled = false;
+        if (strcmp(argv[i], "--no-damage") == 0) idle.enabled = false;
+    }
+    selectSimdKernels(simdOverride);
+    if (replayPath) {
+        startJobs(jobThreads);
+        return runReplay(replayPath);
+    }
+    allocatePools();
+    if (worldCount > 0) {
+        return runWorlds(bench, worldCount);
+    }
+    if (snapshotCheck) {
+        return runSnapshotCheck(bench);
+    }
+    if (particleBench > 0) {
+        return runParticleBench(particleBench);
+    }
+    startJobs(jobThreads);
+    if (simdCheck) {
+        return checkSimdKernels() == 0 ? 0 : 1;
+    }
+    if (headless) {
+        return runHeadless(bench, recordPath);
+    }
+    if (perfSuiteRun) {
+        return runPerfSuite(argc, argv);
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
-    glutInitWindowSize(WIDTH, HEIGHT);
+    glutInitWindowSize(playfield.width, playfield.height);
     glutCreateWindow("Space Defender - 2D OpenGL Game");
 
+    allocateWindowBuffers();
     init();
+    if (frameStatsPath) atexit(writeFrameStats);
 
     glutDisplayFunc(display);
+    glutReshapeFunc(reshape);
 
     // Register keyboard functions
     glutKeyboardFunc(keyboardDown);
@@ -715,8 +6662,14 @@ int main(int argc, char** argv) {
     // Register SPECIAL keyboard functions (for ARROW keys)
     glutSpecialFunc(specialDown);
     glutSpecialUpFunc(specialUp);
+    glutIgnoreKeyRepeat(1); // Holding SPACE autofires at the rate limit instead of the OS repeat rate
 
-    glutTimerFunc(0, update, 0);
+    if (recordPath && replayStartRecording(recordPath, world.seed)) {
+        // Runs after stopSimulation (atexit is last-in, first-out), so every tick is in the file
+        atexit([] { replayStopRecording(world.tick); });
+    }
+    startSimulation();
+    glutIdleFunc(gameLoop);
 
     glutMainLoop();
     return 0;